@@ -47,19 +47,30 @@
 
 / 定义到标准输入、输出: 若勾选，则选手程序（交互题和通信题则是选手程序和接口文件编译出来的程序）会从标准输入读入数据（或向标准输出输出数据），不使用文件 IO。
 
-/ 比较模式: 比较选手输出和标准输出的方式，目前有五种方式：逐行比较模式、忽略多余空格和制表符的逐行比较模式（默认）、外部工具模式、实数比较模式和自定义校验器。
+/ 子任务首个零分即停止: 若勾选，子任务中一旦有测试点得零分，该子任务其余尚未测完的测试点会立即停止并记为跳过。子任务的得分本就取各测试点的最小值，因此得分不变，但错误程序不必再在每个测试点上都跑满时限。
+
+/ 运行时检查输出: 若勾选，且输出定义到标准输出、比较模式为逐行比较、忽略空格或实数比较，则选手程序的输出经管道边写边与标准输出比较，发现第一处不同即结束程序并给出结果，错误程序不必跑满时限，也不会往磁盘写下大量错误输出。此时输出错误优先于程序之后可能出现的运行时错误或超时。仅在 Linux 和 macOS 上生效。
+
+/ 复用相同输出的结果: 若勾选，同一次评测中，与此前某个选手在同一测试点上输出完全相同的输出，直接沿用那次的得分和结果，不再比较或运行校验器。适合运行较慢的自定义校验器，但校验器必须对相同的输入给出相同的结果。校验器文件被修改后，之前的结果不再复用；校验器本身出错的结果不会被复用。
+
+/ 比较模式: 比较选手输出和标准输出的方式，目前有八种方式：逐行比较模式、忽略多余空格和制表符的逐行比较模式（默认）、外部工具模式、实数比较模式、自定义校验器、二进制模式、校验器插件和批量校验器。
 
 逐行比较模式会一行一行比较选手的输出和标准输出是否相同，不同系统平台的换行符不同不会产生影响。
 
 逐行比较模式中也可以选择忽略多余的空格和制表符（这也是推荐的）。
 
-外部工具模式会调用 Linux 下的 `diff` 命令进行比较，但是小心 Windows
-下可能没有 diff。
+外部工具模式按 `diff` 命令的规则进行比较。参数只包含 `--ignore-space-change`（`-b`）、`--ignore-all-space`（`-w`）、`--strip-trailing-cr`、`--text`（`-a`）和 `--brief`（`-q`）时，LemonLime 会自行比较并给出第一处不同的行，不需要安装 diff；使用其他参数时才会调用外部的 `diff` 命令，但是小心 Windows 下可能没有 diff。
 
 实数比较模式会注意读取选手输出和标准输出中的每一个实数，分别比较误差（绝对误差和相对误差）是否在允许范围内，并且判断 `nan` 和 `inf`。
 
 自定义校验器需要选择一个可执行文件作为校验器，具体的说明请参见下一个章节。
 
+二进制模式要求选手输出与标准输出逐字节完全相同，换行符和行末空格的差异也会判为答案错误，适用于输出为二进制文件的题目。
+
+校验器插件需要选择一个动态链接库，说明见下一个章节的插件模式。
+
+批量校验器需要选择一个可执行文件，说明见下一个章节的批量模式。
+
 / 编译器设置: 为每个编译器选择配置，也就是选择相应的编译参数，默认会选择 `default` 配置。
 
 / 选手答案文件扩展名: 这个只在提交答案题可见。对于提交答案题，选手提交的答案文件中，每个文件会和输入文件中去除扩展名后文件名一样的那个配对，这里可以设置选手提交的答案文件的扩展名，默认为 `out`。
@@ -70,6 +81,8 @@
 
 / 接口实现（grader）路径: 这个只在交互题可见。一个实现交互库中的接口的文件。
 
+/ 单独运行交互器: 这个只在交互题可见。若勾选，交互库路径指向的是一个单独运行的交互器，不再与选手程序一起编译，交互库名称和接口实现路径也不再使用。说明见下一个章节的交互题。
+
 / 源文件列表: 这个只在通信题可见。这个应该包含选手的所有要写的程序。可以通过右边的按钮来增删内容。
 
 / 接口文件列表: 这个只在通信题可见。这个应该包含所有要用到的接口文件。可以通过右边的按钮来增删内容。注意这里的路径以 `data` 为根。
@@ -82,6 +95,8 @@
 
 自定义校验器支持 testlib 模式和 lemon 模式。
 
+校验器也可以直接选择源文件（例如 `checker.cpp`），评测开始时 LemonLime 会用扩展名对应的编译器和这道试题的编译器配置把它编译一次，之后所有选手共用编译结果；源文件或编译器设置改变后会重新编译。与源文件同一目录下的头文件（如 `testlib.h`）会一同参与编译。编译失败时会在日志中给出编译器的输出。
+
 === testlib 模式
 
 如果你使用 C++ 编写校验器，我们建议你使用 testlib 编写。testlib 的使用说明可以在 #link("https://oi-wiki.org/intro/testlib/")[OI Wiki] 上见到。
@@ -190,6 +205,115 @@ int main(int argc, char **argv)
 }
 ```
 
+=== 插件模式
+
+前两种模式每个测试点都要启动一次校验器进程，并通过文件交换结果。测试点很多、校验本身很快时，这部分开销可能比校验还大。插件模式下，校验器编译为动态链接库（Linux 下为 `.so`，Windows 下为 `.dll`），每次评测只加载一次，在评测线程中直接调用。
+
+动态链接库需要以 C 链接导出如下函数：
+
+```c
+struct lemon_file {
+    const char *path;
+    const char *data; /* 文件的全部内容，不以 '\0' 结尾 */
+    size_t size;
+};
+
+int lemon_check(const struct lemon_file *input, const struct lemon_file *output,
+                const struct lemon_file *answer, int full_score, int *score,
+                char *message, size_t message_size);
+```
+
+三个参数依次为标准输入、选手输出和标准答案，文件内容已经读入内存。校验完成后，将得分写入 `*score`，将不超过 `message_size` 字节、以 `'\0'` 结尾的 UTF-8 信息写入 `message`，并返回 0；返回其它值表示校验器出错。
+
+需要注意：
+
+- 多个评测线程会同时调用 `lemon_check`，不要使用全局变量保存状态。
+- 校验器与 LemonLime 在同一个进程中运行，校验器崩溃会导致 LemonLime 退出，因此只应使用可信的校验器。
+- 校验器超过时限时无法被强行结束，它会在后台继续运行，此后这次评测中不再调用它。
+- 评测中途修改动态链接库不会生效，需要等到下一次评测。
+
+下面是一个例子，编译命令为 `g++ -O2 -shared -fPIC checker.cpp -o checker.so`。
+
+```cpp
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+struct lemon_file {
+    const char *path;
+    const char *data;
+    size_t size;
+};
+
+extern "C" int lemon_check(const lemon_file *input, const lemon_file *output,
+                           const lemon_file *answer, int full_score, int *score,
+                           char *message, size_t message_size)
+{
+    std::string ps(output->data, output->size), js(answer->data, answer->size);
+    while (! ps.empty() && isspace(ps.back())) ps.pop_back();
+    while (! js.empty() && isspace(js.back())) js.pop_back();
+    *score = ps == js ? full_score : 0;
+    snprintf(message, message_size, "%s", ps == js ? "Success" : "Wrong answer");
+    return 0;
+}
+```
+
+=== 批量模式
+
+用 Python、Java 等语言编写的校验器，启动一次往往就要几百毫秒，比校验本身慢得多。批量模式下，LemonLime 为每位选手的每道试题只启动一次校验器，之后通过标准输入和标准输出依次交给它所有测试点。目前只支持 Linux。
+
+校验器启动时没有参数。每个测试点，LemonLime 会向它的标准输入写入四行：标准输入文件、选手输出文件、标准输出文件的路径，以及这个测试点的满分。校验器需要向标准输出写入一行，格式为 `得分 信息`，写完后记得刷新输出缓冲区，然后等待下一个测试点，直到标准输入结束。
+
+需要注意：
+
+- 同时评测的几个测试点各自使用一个校验器进程，所以同一位选手的校验器也可能不止一个。
+- 校验器超过时限、意外退出或者给出的得分不是整数时，只影响当前的测试点，下一个测试点会重新启动校验器。
+- 校验器的标准错误输出会被丢弃。
+
+已有的 testlib 风格的 Python 校验器（从命令行参数读取三个文件，把结果写到标准错误输出并退出）不需要修改，可以借助下面的脚本在同一个进程中反复运行。把它和校验器 `checker.py` 放在同一个目录，加上可执行权限，再选择这个脚本作为批量校验器即可。校验器不能读取标准输入。
+
+```python
+#!/usr/bin/env python3
+import contextlib
+import io
+import os
+import re
+import runpy
+import sys
+
+CHECKER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "checker.py")
+
+
+def judge(input_file, output_file, answer_file, full_score):
+    sys.argv = [CHECKER, input_file, output_file, answer_file]
+    verdict = io.StringIO()
+    with contextlib.redirect_stdout(io.StringIO()), contextlib.redirect_stderr(verdict):
+        try:
+            runpy.run_path(CHECKER, run_name="__main__")
+        except SystemExit:
+            pass
+    text = " ".join(verdict.getvalue().split())
+    if text.startswith("ok"):
+        return full_score, text
+    if text.startswith("FAIL"):
+        return -1, text
+    m = re.match(r"partially correct \((\d+)\)", text)
+    if m:
+        return int(m.group(1)) * full_score // 100, text
+    m = re.match(r"points ([0-9]*\.[0-9]+|[0-9]+)", text)
+    if m:
+        return int(float(m.group(1)) * full_score), text
+    return 0, text
+
+
+while True:
+    request = [sys.stdin.readline().rstrip("\n") for _ in range(4)]
+    if not request[3]:
+        break
+    score, message = judge(request[0], request[1], request[2], int(request[3]))
+    print(score, message, flush=True)
+```
+
 == 关于非传统型试题
 
 本节介绍了非传统型试题与传统题的区别以及测评逻辑。
@@ -208,12 +332,26 @@ int main(int argc, char **argv)
 
 编译时将交互库拷贝至编译临时目录下并命名为交互库名称，将接口实现文件拷贝至目录下，进行双文件编译。
 
+接口实现文件在每次评测中只编译一次，生成的目标文件与每位选手的程序链接在一起；编译器不支持单独编译（例如编译参数中没有 `-o %s`）时，仍与选手程序一起编译。
+
 对于交互库全部写在一个库文件中的题目（不推荐，选手可能会通过扫内存等方式获得信息），可以创建一个空的接口实现文件 `grader.cpp` 完成配置，不影响编译。
 
+勾选"单独运行交互器"后，选手程序单独编译，交互器作为另一个进程与其同时运行（仅支持 Linux）：选手程序的标准输出接到交互器的标准输入，交互器的标准输出接到选手程序的标准输入，此时无论是否勾选"定义到标准输入、输出"都使用标准输入输出。交互器与 testlib 的交互器相同，运行参数为 `<输入文件> <交互器输出文件> <标准输出文件>`，并将结果写到标准错误输出，结果的格式与 testlib 的自定义校验器相同。交互器若为源文件，会像自定义校验器一样在每次评测中只编译一次。
+
+选手程序运行出错、超时等结果优先于交互器的结果；若交互器在选手程序结束前就判定答案错误，则会结束选手程序，以交互器的结果为准。选手程序结束后，交互器最多还可以运行自定义校验器的时限。交互器无法启动、超时或给出 `FAIL` 时，结果为交互器错误。
+
+双方可能互相等待对方的输出而都不占用 CPU 时间，因此选手程序还受墙钟时间限制：运行超过时限（计入额外时间比例）的两倍再加一秒仍未结束时，结果为超时。
+
+交互器与选手程序一样在沙箱中运行，两者的时间和内存分别统计：交互器的 CPU 时间限制为自定义校验器的时限，内存限制与测试点相同，超出时结果为交互器错误。
+
 === 通信题
 
 编译时将对应的所有文件拷贝至编译临时目录下进行多文件编译。
 
+与交互题一样，接口文件中的源文件在每次评测中只编译一次，之后只需与选手程序链接。需要单独运行的接口程序（`grader.*`）也只编译一次，所有选手共用。
+
+选手的各个程序分别编译时，会同时进行编译，同时编译的数量不超过最大编译线程数量。任何一个程序编译失败，其余仍在编译的程序会被取消；编译信息中会注明出错的是哪个程序。
+
 == 添加新测试点
 
 在左边选中一道试题后，右键鼠标出现菜单，选择"添加测试点"即可添加一个新的测试点，右边会变成测试点设置界面。
@@ -227,6 +365,8 @@ int main(int argc, char **argv)
 如果想要使用子任务依赖的话，对于测试点 i，请保证输入的子任务编号在
 [1,i-1] 之间，多个依赖项之间用半角逗号（`,`）隔开。子任务依赖的意思是这个测试点不会在被依赖的测试点中有错误（不是答案正确，且不是答案部分正确）的情况下测试。注意如果想清空的话，必须点击右边的"清空"按钮。
 
+评测时互不依赖的子任务会同时进行；有依赖的子任务会等到被依赖的子任务全部测完后才开始，而一旦某个被依赖的子任务出错，依赖它的子任务会立即被跳过。
+
 如果要编辑输入输出文件名，直接在表格相应位置双击即可修改。
 
 选中一行或多行后按 `Delete` 键，即可删除对应的输入输出文件。
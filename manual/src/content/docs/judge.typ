@@ -52,6 +52,28 @@
 
 在工具\>选项\>常规中，你可以调整最大评测线程数量，默认为单线程评测，这个功能仍在测试阶段，小心使用!
 
+评测线程以测试点为单位调度：所有选手、所有试题的测试点共用这些线程，某个线程空闲时会接手其他线程尚未开始的测试点，因此评测接近结束时各线程仍能保持忙碌。
+
+评测线程只负责运行选手程序，比较输出和运行校验器由另一组同样数量的线程完成。程序运行结束后，评测线程立即开始下一个测试点，不必等待较慢的校验器；测试点的结果仍然按顺序显示。
+
+选手程序的编译同样由单独的一组线程完成，线程数量即常规选项中的最大编译线程数量，默认为 1。编译会提前于运行进行：评测线程运行某位选手的程序时，后面几位选手的程序已经在编译，编译错误在编译结束时即显示。为了不在临时目录中堆积过多编译好的程序，提前编译的数量以编译线程数加上两倍的评测线程数为限。
+
+== 编译缓存
+
+选手程序的编译结果会保存在用户的缓存目录中（例如 Linux 下的 `~/.cache/` 内），以编译时目录中的全部文件、编译器及其参数和环境变量为依据。重测或者再次评测时，未修改的程序不会重新编译，直接沿用之前的程序和编译信息；不同选手提交的相同程序也只编译一次。只有编译成功和编译错误的结果会被保存，编译超时等结果每次都会重新编译。缓存总大小超过 1 GiB 时，最久未使用的结果会被删除。
+
+== 使用 cgroup 限制资源
+
+在 Linux 下，如果 LemonLime 所在的 cgroup v2 被委派给了当前用户，每次运行选手程序时都会为它单独创建一个 cgroup：内存限制由 `memory.max` 负责，只统计实际使用的内存（预留大量虚拟地址空间的运行时不会再被误判为超过内存限制），运行时间精确到微秒，程序退出后残留的子进程也会被一并结束。例如可以这样启动：
+
+```bash
+systemd-run --user --scope -p Delegate=yes lemon
+```
+
+否则会退回到原先基于 `setrlimit` 的限制方式。
+
+在 Linux 下，每个评测线程会在评测开始时预先启动一个 bubblewrap 沙箱，之后该线程上的测试点都在这个沙箱中运行，不再为每个测试点重新创建命名空间，对于大量运行时间很短的测试点可以明显加快评测。两个测试点之间，上一个程序残留的进程和 `/tmp` 中的文件都会被清除。输入文件与临时目录不在同一个文件系统上且大于 4 MiB 时，该测试点仍会使用单独的沙箱。
+
 == 导出成绩
 
 在 "控制" 菜单中选择 "导出成绩" 可以将结果导出成 HTML 文档或表格文件。
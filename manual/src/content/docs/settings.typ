@@ -86,6 +86,10 @@ LemonLime 没有设置编译器时（比如第一次运行）会自动弹出添
 
 / 解释器视为 Watcher: （仅在 Linux、Mac 下可用）开启此选项后，将不会执行默认的 Watcher，而是将解释器视为 Watcher 执行。这时候，你的解释器需要实现和 Watcher 一样的功能，你需要启动用户程序，严格监控其时间、内存使用；并在用户程序运行结束后，通过 stdout 和 stderr 向 Lemon 汇报结果。相关实现可以参考 #link("https://github.com/Project-LemonLime/Project_LemonLime/tree/master/unix")[默认 Watcher]。借助此功能，你可以更自由地配置特殊题目。同时由于默认的计算解释型语言的运行空间的方案是测量虚拟机的内存，借助此功能，你可以自行访问虚拟机的 API，获得更准确的内存消耗，实现更精确的解释型语言时间、内存测量。最重要的是：Watcher 可以自主报告给 Lemon 程序的运行时间和内存，通过这种方式可以设置一个时间到 WASM Tick 的比例，让 Lemon 支持 WASM Judge。
 
+/ 通过 Shell 运行: （仅在 Linux、Mac 下可用）默认情况下 Watcher 直接执行程序，运行参数只按空格、引号和反斜杠拆分，其中的 `$` 变量、通配符等不会被展开。如果解释器参数确实需要这些功能，可以开启此选项，程序将通过 `bash -c` 运行，但 bash 本身的启动时间也会被计入程序的用时。
+
+/ 预编译头文件: （仅对传统型编译器有效）填写大多数源程序都会包含的头文件，例如 `bits/stdc++.h`。评测时会为每个配置的编译参数生成一次预编译头文件（GCC 的 `.gch` 文件），之后包含该头文件的源程序编译时通过 `-I` 使用它，可以明显缩短编译时间。预编译头文件不适用时（例如编译参数不同，或者使用的不是 GCC），编译器会照常使用原来的头文件，编译结果不受影响。
+
 == 视觉设置
 
 点击上方的 "视觉" 选项卡就能进入视觉配置。
@@ -45,6 +45,10 @@ AdvancedCompilerSettingsDialog::AdvancedCompilerSettingsDialog(QWidget *parent)
 	        &AdvancedCompilerSettingsDialog::disableMemoryLimitCheckChanged);
 	connect(ui->interpreterAsWatcher, &QCheckBox::checkStateChanged, this,
 	        &AdvancedCompilerSettingsDialog::interpreterAsWatcherCheckChanged);
+	connect(ui->runInShell, &QCheckBox::checkStateChanged, this,
+	        &AdvancedCompilerSettingsDialog::runInShellCheckChanged);
+	connect(ui->precompiledHeader, &QLineEdit::textChanged, this,
+	        &AdvancedCompilerSettingsDialog::precompiledHeaderChanged);
 	connect(ui->configurationSelect, qOverload<int>(&QComboBox::currentIndexChanged), this,
 	        &AdvancedCompilerSettingsDialog::configurationIndexChanged);
 	connect(ui->configurationSelect, &QComboBox::editTextChanged, this,
@@ -73,6 +77,8 @@ void AdvancedCompilerSettingsDialog::resetEditCompiler(Compiler *compiler) {
 	ui->memoryLimitRatio->setValue(editCompiler->getMemoryLimitRatio());
 	ui->disableMemoryLimit->setChecked(editCompiler->getDisableMemoryLimitCheck());
 	ui->interpreterAsWatcher->setChecked(editCompiler->getInterpreterAsWatcher());
+	ui->runInShell->setChecked(editCompiler->getRunInShell());
+	ui->precompiledHeader->setText(editCompiler->getPrecompiledHeader());
 	ui->memoryLimitRatio->setEnabled(! editCompiler->getDisableMemoryLimitCheck());
 	QStringList configurationNames = editCompiler->getConfigurationNames();
 	ui->configurationSelect->setEnabled(false);
@@ -149,6 +155,9 @@ void AdvancedCompilerSettingsDialog::compilerTypeChanged() {
 		ui->interpreterArgumentsLabel->setEnabled(false);
 		ui->interpreterArguments->setEnabled(false);
 		ui->interpreterAsWatcher->setEnabled(false);
+		ui->runInShell->setEnabled(false);
+		ui->precompiledHeaderLabel->setEnabled(true);
+		ui->precompiledHeader->setEnabled(true);
 	} else {
 		ui->interpreterLabel->setEnabled(true);
 		ui->interpreterLocation->setEnabled(true);
@@ -156,6 +165,9 @@ void AdvancedCompilerSettingsDialog::compilerTypeChanged() {
 		ui->interpreterArgumentsLabel->setEnabled(true);
 		ui->interpreterArguments->setEnabled(true);
 		ui->interpreterAsWatcher->setEnabled(true);
+		ui->runInShell->setEnabled(true);
+		ui->precompiledHeaderLabel->setEnabled(false);
+		ui->precompiledHeader->setEnabled(false);
 	}
 
 	if (editCompiler->getCompilerType() == Compiler::InterpretiveWithByteCode) {
@@ -243,6 +255,15 @@ void AdvancedCompilerSettingsDialog::interpreterAsWatcherCheckChanged() {
 	editCompiler->setInterpreterAsWatcher(check);
 }
 
+void AdvancedCompilerSettingsDialog::runInShellCheckChanged() {
+	bool check = ui->runInShell->isChecked();
+	editCompiler->setRunInShell(check);
+}
+
+void AdvancedCompilerSettingsDialog::precompiledHeaderChanged() {
+	editCompiler->setPrecompiledHeader(ui->precompiledHeader->text());
+}
+
 void AdvancedCompilerSettingsDialog::configurationIndexChanged() {
 	if (! ui->configurationSelect->isEnabled())
 		return;
@@ -44,6 +44,8 @@ class AdvancedCompilerSettingsDialog : public QDialog {
 	void memoryLimitRatioChanged();
 	void disableMemoryLimitCheckChanged();
 	void interpreterAsWatcherCheckChanged();
+	void runInShellCheckChanged();
+	void precompiledHeaderChanged();
 	void configurationIndexChanged();
 	void configurationTextChanged();
 	void deleteConfiguration();
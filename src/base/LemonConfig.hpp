@@ -27,6 +27,7 @@ namespace Lemon::base::config {
 		int fileSizeLimit{};
 		int rejudgeTimes{};
 		int maxJudgingThreads{};
+		int maxCompilingThreads{};
 		QString defaultInputFileExtension;
 		QString defaultOutputFileExtension;
 		QStringList inputFileExtensions;
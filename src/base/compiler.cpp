@@ -17,6 +17,7 @@ Compiler::Compiler(QObject *parent) : QObject(parent) {
 	memoryLimitRatio = 1;
 	disableMemoryLimitCheck = false;
 	interpreterAsWatcher = false;
+	runInShell = false;
 }
 
 auto Compiler::getCompilerType() const -> Compiler::CompilerType { return compilerType; }
@@ -47,6 +48,10 @@ auto Compiler::getDisableMemoryLimitCheck() const -> bool { return disableMemory
 
 auto Compiler::getInterpreterAsWatcher() const -> bool { return interpreterAsWatcher; }
 
+auto Compiler::getRunInShell() const -> bool { return runInShell; }
+
+auto Compiler::getPrecompiledHeader() const -> const QString & { return precompiledHeader; }
+
 void Compiler::setCompilerType(Compiler::CompilerType type) { compilerType = type; }
 
 void Compiler::setCompilerName(const QString &name) { compilerName = name; }
@@ -73,6 +78,10 @@ void Compiler::setDisableMemoryLimitCheck(bool check) { disableMemoryLimitCheck
 
 void Compiler::setInterpreterAsWatcher(bool use) { interpreterAsWatcher = use; }
 
+void Compiler::setRunInShell(bool use) { runInShell = use; }
+
+void Compiler::setPrecompiledHeader(const QString &header) { precompiledHeader = header.trimmed(); }
+
 void Compiler::addConfiguration(const QString &name, const QString &arguments1, const QString &arguments2) {
 	configurationNames.append(name);
 	compilerArguments.append(arguments1);
@@ -120,6 +129,8 @@ void Compiler::copyFrom(Compiler *other) {
 	memoryLimitRatio = other->getMemoryLimitRatio();
 	disableMemoryLimitCheck = other->getDisableMemoryLimitCheck();
 	interpreterAsWatcher = other->getInterpreterAsWatcher();
+	runInShell = other->getRunInShell();
+	precompiledHeader = other->getPrecompiledHeader();
 }
 
 int Compiler::read(const QJsonObject &json) {
@@ -151,6 +162,8 @@ int Compiler::read(const QJsonObject &json) {
 	READ_JSON(json, memoryLimitRatio);
 	READ_JSON(json, disableMemoryLimitCheck);
 	READ_JSON(json, interpreterAsWatcher);
+	READ_JSON(json, runInShell);
+	READ_JSON(json, precompiledHeader);
 	return 0;
 }
 
@@ -172,4 +185,6 @@ void Compiler::write(QJsonObject &json) const {
 	WRITE_JSON(json, memoryLimitRatio);        // double
 	WRITE_JSON(json, disableMemoryLimitCheck); // bool
 	WRITE_JSON(json, interpreterAsWatcher);    // bool
+	WRITE_JSON(json, runInShell);              // bool
+	WRITE_JSON(json, precompiledHeader);
 }
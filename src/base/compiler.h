@@ -35,6 +35,8 @@ class Compiler : public QObject {
 	double getMemoryLimitRatio() const;
 	bool getDisableMemoryLimitCheck() const;
 	bool getInterpreterAsWatcher() const;
+	bool getRunInShell() const;
+	const QString &getPrecompiledHeader() const;
 
 	void setCompilerType(CompilerType);
 	void setCompilerName(const QString &);
@@ -47,6 +49,8 @@ class Compiler : public QObject {
 	void setMemoryLimitRatio(double);
 	void setDisableMemoryLimitCheck(bool);
 	void setInterpreterAsWatcher(bool);
+	void setRunInShell(bool);
+	void setPrecompiledHeader(const QString &);
 
 	void addConfiguration(const QString &, const QString &, const QString &);
 	void setConfigName(int, const QString &);
@@ -74,4 +78,7 @@ class Compiler : public QObject {
 	double memoryLimitRatio;
 	bool disableMemoryLimitCheck;
 	bool interpreterAsWatcher;
+	bool runInShell;
+	// As included by the sources, such as bits/stdc++.h, empty if none
+	QString precompiledHeader;
 };
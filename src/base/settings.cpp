@@ -124,6 +124,8 @@ auto Settings::getRejudgeTimes() const -> int { return rejudgeTimes; }
 
 auto Settings::getMaxJudgingThreads() const -> int { return maxJudgingThreads; }
 
+auto Settings::getMaxCompilingThreads() const -> int { return maxCompilingThreads; }
+
 auto Settings::getDefaultExtraTimeRatio() const -> double { return defaultExtraTimeRatio; }
 
 auto Settings::getDefaultInputFileExtension() const -> const QString & { return defaultInputFileExtension; }
@@ -192,6 +194,11 @@ void Settings::setMaxJudgingThreads(int number) {
 	DEBUG("Set Max Judging Threads to " + QString::number(number));
 }
 
+void Settings::setMaxCompilingThreads(int number) {
+	maxCompilingThreads = number;
+	DEBUG("Set Max Compiling Threads to " + QString::number(number));
+}
+
 void Settings::setDefaultInputFileExtension(const QString &extension) {
 	defaultInputFileExtension = extension;
 	DEBUG("Set Default InputFile Extension to " + extension);
@@ -378,6 +385,7 @@ void Settings::copyFrom(Settings *other) {
 	setFileSizeLimit(other->getFileSizeLimit());
 	setRejudgeTimes(other->getRejudgeTimes());
 	setMaxJudgingThreads(other->getMaxJudgingThreads());
+	setMaxCompilingThreads(other->getMaxCompilingThreads());
 	setDefaultInputFileExtension(other->getDefaultInputFileExtension());
 	setDefaultOutputFileExtension(other->getDefaultOutputFileExtension());
 	setInputFileExtensions(other->getInputFileExtensions().join(";"));
@@ -427,6 +435,7 @@ void Settings::saveSettings() {
 	settings.setValue("FileSizeLimit", fileSizeLimit);
 	settings.setValue("MaximumRejudgeTimes", rejudgeTimes);
 	settings.setValue("MaximumJudgingThreads", maxJudgingThreads);
+	settings.setValue("MaximumCompilingThreads", maxCompilingThreads);
 	settings.setValue("DefaultInputFileExtension", defaultInputFileExtension);
 	settings.setValue("DefaultOutputFileExtension", defaultOutputFileExtension);
 	settings.setValue("InputFileExtensions", inputFileExtensions);
@@ -484,6 +493,8 @@ void Settings::saveSettings() {
 		settings.setValue("MemoryLimitRatio", compilerList[i]->getMemoryLimitRatio());
 		settings.setValue("DisableMemoryLimitCheck", compilerList[i]->getDisableMemoryLimitCheck());
 		settings.setValue("InterpreterAsWatcher", compilerList[i]->getInterpreterAsWatcher());
+		settings.setValue("RunInShell", compilerList[i]->getRunInShell());
+		settings.setValue("PrecompiledHeader", compilerList[i]->getPrecompiledHeader());
 		QStringList configurationNames = compilerList[i]->getConfigurationNames();
 		QStringList compilerArguments = compilerList[i]->getCompilerArguments();
 		QStringList interpreterArguments = compilerList[i]->getInterpreterArguments();
@@ -532,6 +543,7 @@ void Settings::loadSettings() {
 	fileSizeLimit = settings.value("FileSizeLimit", 50).toInt();
 	rejudgeTimes = settings.value("MaximumRejudgeTimes", 1).toInt();
 	maxJudgingThreads = settings.value("MaximumJudgingThreads", 1).toInt();
+	maxCompilingThreads = settings.value("MaximumCompilingThreads", 1).toInt();
 	defaultInputFileExtension = settings.value("DefaultInputFileExtension", "in").toString();
 	defaultOutputFileExtension = settings.value("DefaultOutputFileExtension", "out").toString();
 	inputFileExtensions = settings.value("InputFileExtensions", QStringList() << "in").toStringList();
@@ -609,6 +621,8 @@ void Settings::loadSettings() {
 		compiler->setMemoryLimitRatio(settings.value("MemoryLimitRatio").toDouble());
 		compiler->setDisableMemoryLimitCheck(settings.value("DisableMemoryLimitCheck").toBool());
 		compiler->setInterpreterAsWatcher(settings.value("InterpreterAsWatcher").toBool());
+		compiler->setRunInShell(settings.value("RunInShell").toBool());
+		compiler->setPrecompiledHeader(settings.value("PrecompiledHeader").toString());
 		int configurationCount = settings.beginReadArray("Configuration");
 
 		for (int j = 0; j < configurationCount; j++) {
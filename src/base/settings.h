@@ -85,6 +85,7 @@ class Settings {
 	int getFileSizeLimit() const;
 	int getRejudgeTimes() const;
 	int getMaxJudgingThreads() const;
+	int getMaxCompilingThreads() const;
 	double getDefaultExtraTimeRatio() const;
 	const QString &getDefaultInputFileExtension() const;
 	const QString &getDefaultOutputFileExtension() const;
@@ -106,6 +107,7 @@ class Settings {
 	void setFileSizeLimit(int);
 	void setRejudgeTimes(int);
 	void setMaxJudgingThreads(int);
+	void setMaxCompilingThreads(int);
 	void setDefaultInputFileExtension(const QString &);
 	void setDefaultOutputFileExtension(const QString &);
 	void setInputFileExtensions(const QString &);
@@ -154,6 +156,7 @@ class Settings {
 	int fileSizeLimit{};
 	int rejudgeTimes{};
 	int maxJudgingThreads{};
+	int maxCompilingThreads{};
 	double defaultExtraTimeRatio{};
 	QString defaultInputFileExtension;
 	QString defaultOutputFileExtension;
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "answercache.h"
+#include "core/outputreader.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+AnswerCache::AnswerCache(qint64 budget) : budget(budget) {}
+
+auto AnswerCache::contents(const QString &fileName) -> std::shared_ptr<const QByteArray> {
+	QFileInfo info(fileName);
+	const Key key{info.absoluteFilePath(), Contents};
+
+	if (auto data = find(key, info.lastModified(), info.size()))
+		return std::static_pointer_cast<const QByteArray>(data);
+
+	if (info.size() > budget / 4)
+		return nullptr;
+
+	QFile file(fileName);
+
+	if (! file.open(QFile::ReadOnly))
+		return nullptr;
+
+	auto data = std::make_shared<const QByteArray>(file.readAll());
+	insert(key, {data, data->size(), info.lastModified(), info.size()});
+	return data;
+}
+
+auto AnswerCache::realNumbers(const QString &fileName) -> std::shared_ptr<const RealNumbers> {
+	QFileInfo info(fileName);
+	const Key key{info.absoluteFilePath(), Numbers};
+
+	if (auto data = find(key, info.lastModified(), info.size()))
+		return std::static_pointer_cast<const RealNumbers>(data);
+
+	// Up to 17 bytes for each number of two chars, as in "0 1 0"
+	if (info.size() * 9 > budget / 4)
+		return nullptr;
+
+	OutputReader reader(fileName);
+
+	if (! reader.valid())
+		return nullptr;
+
+	auto numbers = std::make_shared<RealNumbers>();
+	long double value = 0;
+
+	while ((numbers->end = reader.nextReal(value)) == 1) {
+		numbers->values.push_back(value);
+		numbers->next.push_back(static_cast<char>(reader.nextChar()));
+	}
+
+	numbers->values.shrink_to_fit();
+	numbers->next.shrink_to_fit();
+
+	auto size = static_cast<qint64>(numbers->values.size() * (sizeof(long double) + 1));
+	insert(key, {numbers, size, info.lastModified(), info.size()});
+	return numbers;
+}
+
+auto AnswerCache::find(const Key &key, const QDateTime &modified, qint64 fileSize)
+    -> std::shared_ptr<const void> {
+	QMutexLocker locker(&mutex);
+	auto entry = entries.find(key);
+
+	if (entry == entries.end())
+		return nullptr;
+
+	if (entry->modified != modified || entry->fileSize != fileSize) {
+		used -= entry->size;
+		entries.erase(entry);
+		return nullptr;
+	}
+
+	entry->lastUse = ++clock;
+	return entry->data;
+}
+
+void AnswerCache::insert(const Key &key, Entry entry) {
+	QMutexLocker locker(&mutex);
+
+	// Another thread read the same file meanwhile
+	if (entries.contains(key))
+		return;
+
+	while (! entries.isEmpty() && used + entry.size > budget) {
+		auto oldest = entries.begin();
+
+		for (auto it = entries.begin(); it != entries.end(); ++it)
+			if (it->lastUse < oldest->lastUse)
+				oldest = it;
+
+		used -= oldest->size;
+		entries.erase(oldest);
+	}
+
+	entry.lastUse = ++clock;
+	used += entry.size;
+	entries.insert(key, std::move(entry));
+}
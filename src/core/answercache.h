@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Standard output files of a judge session, read once and shared by every
+// contestant judged against them. The comparators skip equal stretches with
+// a vector comparison already, so the line and space modes keep the plain
+// contents; the real number mode keeps the numbers parsed.
+//
+// The least recently used files are dropped once the cache holds more than
+// its budget. Files too large to fit a quarter of it are not kept at all,
+// lookups give nullptr for them and the caller reads the file itself.
+class AnswerCache {
+  public:
+	struct RealNumbers {
+		std::vector<long double> values;
+		// What OutputReader::nextChar() gives after each number
+		std::vector<char> next;
+		// What OutputReader::nextReal() gives after the last number, 0 or EOF
+		int end{};
+	};
+
+	explicit AnswerCache(qint64 budget = 256 * 1024 * 1024);
+	AnswerCache(const AnswerCache &) = delete;
+	AnswerCache &operator=(const AnswerCache &) = delete;
+
+	// Both thread-safe, nullptr also if the file cannot be read
+	std::shared_ptr<const QByteArray> contents(const QString &fileName);
+	std::shared_ptr<const RealNumbers> realNumbers(const QString &fileName);
+
+  private:
+	enum Kind { Contents, Numbers };
+	using Key = std::pair<QString, int>;
+
+	struct Entry {
+		std::shared_ptr<const void> data;
+		qint64 size{};
+		// The file as it was read, an edited one is read again
+		QDateTime modified;
+		qint64 fileSize{};
+		quint64 lastUse{};
+	};
+
+	const qint64 budget;
+	QMutex mutex;
+	QHash<Key, Entry> entries;
+	qint64 used{};
+	quint64 clock{};
+
+	std::shared_ptr<const void> find(const Key &, const QDateTime &modified, qint64 fileSize);
+	void insert(const Key &, Entry);
+};
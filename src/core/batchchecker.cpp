@@ -0,0 +1,216 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "batchchecker.h"
+#include "base/LemonLog.hpp"
+
+#include <QDeadlineTimer>
+#include <QFile>
+#include <QMutexLocker>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#define LEMON_MODULE_NAME "BatchChecker"
+
+struct BatchChecker::Process {
+	ProcessLauncher launcher;
+	// Both the standard input and output of the checker
+	int socket{-1};
+	// Received past the end of the last answer
+	QByteArray pending;
+
+	// Gives the checker an end of file, then ~ProcessLauncher() kills it
+	~Process() {
+#ifdef Q_OS_LINUX
+		if (socket != -1)
+			::close(socket);
+#endif
+	}
+};
+
+#ifdef Q_OS_LINUX
+
+namespace {
+	// Far more than a score and a message need
+	constexpr qsizetype maxAnswerLength = 1 << 20;
+
+	auto sendRequest(int socket, const QByteArray &request) -> bool {
+		qsizetype sent = 0;
+
+		while (sent < request.size()) {
+			ssize_t length = ::send(socket, request.constData() + sent, request.size() - sent, MSG_NOSIGNAL);
+
+			if (length < 0 && errno != EINTR)
+				return false;
+
+			if (length > 0)
+				sent += length;
+		}
+
+		return true;
+	}
+
+	auto readAnswer(int socket, QByteArray &pending, const QDeadlineTimer &deadline, const StopSignal *stop,
+	                QByteArray &answer) -> BatchChecker::Status {
+		while (true) {
+			qsizetype end = pending.indexOf('\n');
+
+			if (end != -1) {
+				answer = pending.left(end);
+				pending.remove(0, end + 1);
+				return BatchChecker::Checked;
+			}
+
+			if (pending.size() > maxAnswerLength)
+				return BatchChecker::Failed;
+
+			if (stop && stop->isRaised())
+				return BatchChecker::Stopped;
+
+			if (deadline.hasExpired())
+				return BatchChecker::TimedOut;
+
+			pollfd descriptors[2] = {{socket, POLLIN, 0}, {stop ? stop->getDescriptor() : -1, POLLIN, 0}};
+			auto timeout = static_cast<int>(deadline.remainingTime());
+
+			// Without an eventfd the stop request has to be polled for
+			if (stop && stop->getDescriptor() == -1)
+				timeout = qMin(timeout, 10);
+
+			if (::poll(descriptors, 2, timeout) <= 0 || descriptors[0].revents == 0)
+				continue;
+
+			char chunk[4096];
+			ssize_t length = ::recv(socket, chunk, sizeof(chunk), 0);
+
+			if (length > 0)
+				pending.append(chunk, length);
+			else if (length == 0 || (errno != EINTR && errno != EAGAIN))
+				return BatchChecker::Failed;
+		}
+	}
+} // namespace
+
+#endif
+
+BatchChecker::BatchChecker(const QString &fileName) : program(fileName) {}
+
+BatchChecker::~BatchChecker() = default;
+
+auto BatchChecker::takeIdle() -> std::unique_ptr<Process> {
+	QMutexLocker locker(&mutex);
+
+	if (idle.empty())
+		return nullptr;
+
+	auto process = std::move(idle.back());
+	idle.pop_back();
+	return process;
+}
+
+auto BatchChecker::start() -> std::unique_ptr<Process> {
+#ifdef Q_OS_LINUX
+	int sockets[2];
+
+	if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0)
+		return nullptr;
+
+	auto process = std::make_unique<Process>();
+	process->socket = sockets[0];
+	process->launcher.setProgram(program, QStringList());
+	// Both replaced by the socket, and nobody reads what goes to stderr
+	process->launcher.setStandardOutputFile("/dev/null");
+	process->launcher.setStandardErrorFile("/dev/null");
+	process->launcher.inheritDescriptor(sockets[1], STDIN_FILENO);
+	process->launcher.inheritDescriptor(sockets[1], STDOUT_FILENO);
+
+	bool started = process->launcher.start();
+	::close(sockets[1]);
+
+	if (! started) {
+		WARN("Cannot start the batch special judge", program);
+		return nullptr;
+	}
+
+	return process;
+#else
+	return nullptr;
+#endif
+}
+
+void BatchChecker::release(std::unique_ptr<Process> process) {
+	QMutexLocker locker(&mutex);
+	idle.push_back(std::move(process));
+}
+
+#ifdef Q_OS_LINUX
+
+auto BatchChecker::check(const QString &inputFile, const QString &outputFile, const QString &answerFile,
+                         int fullScore, int timeLimit, const StopSignal *stop) -> Result {
+	Result result;
+	const QByteArray request = QFile::encodeName(inputFile) + '\n' + QFile::encodeName(outputFile) + '\n' +
+	                           QFile::encodeName(answerFile) + '\n' + QByteArray::number(fullScore) + '\n';
+	QDeadlineTimer deadline(timeLimit);
+	QByteArray answer;
+	Status status = Failed;
+	auto process = takeIdle();
+
+	if (process && sendRequest(process->socket, request))
+		status = readAnswer(process->socket, process->pending, deadline, stop, answer);
+
+	// None was idle, or the idle one went away meanwhile, which is not the
+	// fault of this test case
+	if (status == Failed) {
+		process = start();
+
+		if (! process) {
+			result.message = QObject::tr("Cannot start the special judge");
+			return result;
+		}
+
+		if (sendRequest(process->socket, request))
+			status = readAnswer(process->socket, process->pending, deadline, stop, answer);
+	}
+
+	result.status = status;
+
+	// Anything else leaves the checker in the middle of a case
+	if (status != Checked)
+		return result;
+
+	release(std::move(process));
+
+	const QString line = QString::fromUtf8(answer).trimmed();
+	const qsizetype space = line.indexOf(QLatin1Char(' '));
+	bool isNumber = false;
+
+	result.score = line.left(space).toInt(&isNumber);
+
+	if (! isNumber)
+		result.score = -1;
+
+	if (space != -1)
+		result.message = line.mid(space + 1);
+
+	return result;
+}
+
+#else
+
+auto BatchChecker::check(const QString &, const QString &, const QString &, int, int, const StopSignal *)
+    -> Result {
+	Result result;
+	result.message = QObject::tr("Batch special judges are only supported on Linux");
+	return result;
+}
+
+#endif
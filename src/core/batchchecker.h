@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include "processlauncher.h"
+
+#include <QMutex>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+// A special judge that keeps running for all the test cases of a contestant's
+// task, so that a checker with a slow start (Python, Java) pays for it once
+// instead of once per case. It is started without arguments and talks over
+// its standard input and output: for each case it is sent four lines
+//
+//   <standard input file>
+//   <contestant output file>
+//   <standard output file>
+//   <full score>
+//
+// and answers with a single line, "<score> <message>". Exiting, or anything
+// but an integer score, fails the case at hand only: the next one starts the
+// checker again.
+//
+// Cases judged at the same time each get a checker of their own, which goes
+// back to the idle ones when it has answered.
+class BatchChecker {
+  public:
+	enum Status { Checked, Failed, TimedOut, Stopped, Unusable };
+
+	struct Result {
+		Status status = Unusable;
+		int score = 0;
+		QString message;
+	};
+
+	explicit BatchChecker(const QString &fileName);
+	~BatchChecker();
+	BatchChecker(const BatchChecker &) = delete;
+	BatchChecker &operator=(const BatchChecker &) = delete;
+
+	Result check(const QString &inputFile, const QString &outputFile, const QString &answerFile,
+	             int fullScore, int timeLimit, const StopSignal *);
+
+  private:
+	struct Process;
+
+	QString program;
+	QMutex mutex;
+	std::vector<std::unique_ptr<Process>> idle;
+
+	std::unique_ptr<Process> takeIdle();
+	std::unique_ptr<Process> start();
+	void release(std::unique_ptr<Process>);
+};
@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "buildcache.h"
+#include "base/LemonLog.hpp"
+#include "core/fieldhash.h"
+#include "core/processlauncher.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#define LEMON_MODULE_NAME "BuildCache"
+
+auto BuildCache::key(const Job &job) -> QByteArray {
+	FieldHash hash;
+
+	for (const auto &[path, name] : job.files) {
+		QFile file(path);
+		hash.addField(name.toUtf8());
+
+		// Not to be built, and not worth remembering
+		if (! hash.addFile(file))
+			return {};
+	}
+
+	hash.addField(job.compiler.toUtf8());
+
+	QStringList environment = job.environment.toStringList();
+	environment.sort();
+
+	for (const auto &variable : std::as_const(environment))
+		hash.addField(variable.toUtf8());
+
+	for (const auto &command : job.commands) {
+		hash.addField(QByteArray::number(command.size()));
+
+		for (const auto &argument : command)
+			hash.addField(argument.toUtf8());
+	}
+
+	for (const auto &output : job.outputs)
+		hash.addField(output.toUtf8());
+
+	return hash.result();
+}
+
+auto BuildCache::build(const Job &job, int timeLimit, const StopSignal *stop) -> Result {
+	const QByteArray jobKey = key(job);
+
+	if (jobKey.isEmpty() || ! directory.isValid()) {
+		Result result;
+		result.message = QObject::tr("Cannot read the files to build");
+		return result;
+	}
+
+	std::shared_ptr<Entry> entry;
+
+	{
+		QMutexLocker locker(&mutex);
+		auto &slot = entries[jobKey];
+
+		if (! slot)
+			slot = std::make_shared<Entry>();
+
+		entry = slot;
+	}
+
+	// Held while building, so that the others asking for it wait
+	QMutexLocker locker(&entry->mutex);
+
+	if (entry->done)
+		return entry->result;
+
+	const QString buildDirectory = directory.filePath(QString::fromLatin1(jobKey));
+	QDir(buildDirectory).removeRecursively();
+
+	if (! QDir().mkpath(buildDirectory)) {
+		Result result;
+		result.message = QObject::tr("Cannot create the build directory");
+		return result;
+	}
+
+	Result result = run(job, buildDirectory, timeLimit, stop);
+
+	// Left to be built again by whoever asks next
+	if (stop && stop->isRaised())
+		return result;
+
+	entry->result = result;
+	entry->done = true;
+	return result;
+}
+
+auto BuildCache::run(const Job &job, const QString &buildDirectory, int timeLimit, const StopSignal *stop)
+    -> Result {
+	Result result;
+	result.directory = buildDirectory;
+
+	for (const auto &[path, name] : job.files) {
+		if (! QFile::copy(path, buildDirectory + QDir::separator() + name)) {
+			result.message = QObject::tr("Cannot copy %1").arg(path);
+			return result;
+		}
+	}
+
+	// The compiler does not make the directories of the outputs
+	for (const auto &output : job.outputs)
+		QDir(buildDirectory).mkpath(QFileInfo(output).path());
+
+	for (const auto &command : job.commands) {
+		ProcessLauncher compiler(stop);
+		compiler.setMergedChannels(true);
+		compiler.setProcessEnvironment(job.environment);
+		compiler.setWorkingDirectory(buildDirectory);
+		compiler.setProgram(job.compiler, command);
+
+		if (! compiler.start()) {
+			result.message = QObject::tr("Cannot start the compiler");
+			return result;
+		}
+
+		ProcessLauncher::WaitResult status = compiler.waitForFinished(timeLimit);
+
+		if (status != ProcessLauncher::Finished) {
+			compiler.kill();
+
+			if (status == ProcessLauncher::TimedOut)
+				result.message = QObject::tr("Compile time limit exceeded");
+
+			return result;
+		}
+
+		if (compiler.exitCode() != 0) {
+			result.message = QString::fromLocal8Bit(compiler.readAllStandardOutput());
+			return result;
+		}
+	}
+
+	for (const auto &output : job.outputs) {
+		if (! QFileInfo::exists(buildDirectory + QDir::separator() + output)) {
+			result.message = QObject::tr("The compiler did not produce %1").arg(output);
+			return result;
+		}
+	}
+
+	LOG("Built", job.outputs.join(' '), "in", buildDirectory);
+	result.succeeded = true;
+	return result;
+}
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QProcessEnvironment>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <memory>
+
+class StopSignal;
+
+// Builds what comes with a task, such as a special judge or the graders, once
+// for a judge session instead of once for each contestant. A build is known by
+// a hash of everything it is given, so that it is done again only when the
+// sources or the compiler settings change.
+class BuildCache {
+  public:
+	struct Job {
+		// Source path and name in the build directory
+		QList<QPair<QString, QString>> files;
+		QString compiler;
+		QProcessEnvironment environment;
+		// The compiler is run once for each, in the build directory
+		QList<QStringList> commands;
+		// Names of what the commands leave behind, relative to the build directory
+		QStringList outputs;
+	};
+
+	struct Result {
+		bool succeeded{};
+		// Holds the outputs, must not be written to
+		QString directory;
+		// What the compiler said when it failed
+		QString message;
+	};
+
+	// Thread-safe, a build asked for again while it runs is waited for
+	Result build(const Job &, int timeLimit, const StopSignal *);
+
+  private:
+	struct Entry {
+		QMutex mutex;
+		bool done{};
+		Result result;
+	};
+
+	QTemporaryDir directory;
+	QMutex mutex;
+	QHash<QByteArray, std::shared_ptr<Entry>> entries;
+
+	static QByteArray key(const Job &);
+	Result run(const Job &, const QString &buildDirectory, int timeLimit, const StopSignal *);
+};
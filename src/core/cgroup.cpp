@@ -0,0 +1,226 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#ifdef Q_OS_LINUX
+
+#include "cgroup.h"
+#include "base/LemonLog.hpp"
+
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+
+#include <atomic>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <utility>
+
+#define LEMON_MODULE_NAME "Cgroup"
+
+namespace {
+	const QString cgroupMount = "/sys/fs/cgroup";
+
+	auto readFile(const QString &fileName) -> QByteArray {
+		QFile file(fileName);
+
+		if (! file.open(QFile::ReadOnly))
+			return QByteArray();
+
+		return file.readAll();
+	}
+
+	auto writeFile(const QString &fileName, const QByteArray &value) -> bool {
+		QFile file(fileName);
+
+		// cgroup files reject partial writes, so write in one go, unbuffered
+		if (! file.open(QFile::WriteOnly | QFile::Unbuffered))
+			return false;
+
+		return file.write(value) == value.size();
+	}
+
+	// Wait until no process is left in the cgroup at `path`, as told by
+	// cgroup.events, which wakes up poll() whenever it changes
+	auto waitUntilEmpty(const QString &path, int msecs) -> bool {
+		const int descriptor =
+		    ::open(QFile::encodeName(path + "/cgroup.events").constData(), O_RDONLY | O_CLOEXEC);
+
+		if (descriptor == -1)
+			return false;
+
+		const QDeadlineTimer deadline(msecs);
+		bool empty = false;
+
+		while (true) {
+			char buffer[256];
+			const ssize_t size = ::pread(descriptor, buffer, sizeof buffer - 1, 0);
+
+			if (size < 0)
+				break;
+
+			if (QByteArray(buffer, size).contains("populated 0")) {
+				empty = true;
+				break;
+			}
+
+			pollfd events{descriptor, POLLPRI, 0};
+
+			if (::poll(&events, 1, static_cast<int>(deadline.remainingTime())) <= 0)
+				break;
+		}
+
+		::close(descriptor);
+		return empty;
+	}
+} // namespace
+
+Cgroup::Cgroup(QString path) : path(std::move(path)) {}
+
+Cgroup::~Cgroup() {
+	kill();
+
+	if (procsDescriptor != -1)
+		::close(procsDescriptor);
+
+	// The killed processes leave the cgroup asynchronously
+	waitUntilEmpty(path, 100);
+
+	if (! QDir().rmdir(path))
+		WARN("Cannot remove", path);
+}
+
+auto Cgroup::isAvailable() -> bool { return ! delegatedRoot().isEmpty(); }
+
+auto Cgroup::create() -> std::unique_ptr<Cgroup> {
+	static std::atomic<int> counter{0};
+
+	const QString &root = delegatedRoot();
+
+	if (root.isEmpty())
+		return nullptr;
+
+	QString name = QString("run-%1-%2").arg(QCoreApplication::applicationPid()).arg(counter++);
+
+	if (! QDir(root).mkdir(name)) {
+		WARN("Cannot create cgroup", name);
+		return nullptr;
+	}
+
+	std::unique_ptr<Cgroup> cgroup(new Cgroup(root + "/" + name));
+	cgroup->procsDescriptor =
+	    ::open(QFile::encodeName(cgroup->path + "/cgroup.procs").constData(), O_WRONLY | O_CLOEXEC);
+
+	if (cgroup->procsDescriptor == -1)
+		return nullptr;
+
+	return cgroup;
+}
+
+auto Cgroup::write(const QString &file, const QByteArray &value) const -> bool {
+	return writeFile(path + "/" + file, value);
+}
+
+auto Cgroup::read(const QString &file, const QString &key) const -> qint64 {
+	const QList<QByteArray> lines = readFile(path + "/" + file).split('\n');
+
+	for (const auto &line : lines) {
+		const QList<QByteArray> fields = line.split(' ');
+
+		if (key.isEmpty() && fields.size() == 1 && ! fields[0].isEmpty())
+			return fields[0].toLongLong();
+
+		if (! key.isEmpty() && fields.size() == 2 && fields[0] == key.toLatin1())
+			return fields[1].toLongLong();
+	}
+
+	return -1;
+}
+
+auto Cgroup::getProcsDescriptor() const -> int { return procsDescriptor; }
+
+void Cgroup::kill() const {
+	// cgroup.kill needs Linux 5.14, signal the processes one by one before that
+	if (write("cgroup.kill", "1"))
+		return;
+
+	for (int i = 0; i < 100; i++) {
+		const QList<QByteArray> pids = readFile(path + "/cgroup.procs").split('\n');
+		bool empty = true;
+
+		for (const auto &pid : pids) {
+			if (pid.isEmpty())
+				continue;
+
+			empty = false;
+			::kill(pid.toInt(), SIGKILL);
+		}
+
+		if (empty)
+			return;
+
+		QThread::msleep(1);
+	}
+}
+
+auto Cgroup::delegatedRoot() -> const QString & {
+	static const QString root = [] {
+		QString own;
+
+		for (const auto &line : readFile("/proc/self/cgroup").split('\n'))
+			if (line.startsWith("0::"))
+				own = cgroupMount + QString::fromUtf8(line.mid(3));
+
+		if (own.isEmpty() || ! QFile::exists(own + "/cgroup.controllers"))
+			return QString();
+
+		const QList<QByteArray> controllers = readFile(own + "/cgroup.controllers").simplified().split(' ');
+
+		if (! controllers.contains("memory") || ! controllers.contains("pids"))
+			return QString();
+
+		if (::access(QFile::encodeName(own + "/cgroup.subtree_control").constData(), W_OK) != 0)
+			return QString();
+
+		const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+
+		// Others, such as the shell we were started from, would keep the
+		// controllers from being enabled, and are not ours to move
+		if (readFile(own + "/cgroup.procs").trimmed() != pid) {
+			LOG("cgroup is shared with other processes, falling back to rlimits");
+			return QString();
+		}
+
+		// A cgroup with enabled controllers cannot hold processes itself
+		// (except the root), so move the judge into a leaf of its own first.
+		QDir(own).mkdir("supervisor");
+
+		if (! writeFile(own + "/supervisor/cgroup.procs", pid)) {
+			LOG("cgroup v2 is not delegated, falling back to rlimits");
+			QDir(own).rmdir("supervisor");
+			return QString();
+		}
+
+		if (! writeFile(own + "/cgroup.subtree_control", "+memory +pids")) {
+			LOG("cgroup v2 is not delegated, falling back to rlimits");
+			// Back to where we were, as if nothing had been tried
+			writeFile(own + "/cgroup.procs", pid);
+			QDir(own).rmdir("supervisor");
+			return QString();
+		}
+
+		LOG("Running programs in cgroups under", own);
+		return own;
+	}();
+
+	return root;
+}
+
+#endif
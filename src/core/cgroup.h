@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#ifdef Q_OS_LINUX
+
+#include <QByteArray>
+#include <QString>
+#include <memory>
+
+// A leaf of the cgroup v2 hierarchy delegated to LemonLime, holding one run.
+//
+// On first use the judge moves itself into a "supervisor" leaf of its own
+// cgroup and enables the memory and pids controllers there, so that the runs
+// can be created as siblings. This only works when the cgroup has been
+// delegated to us (e.g. `systemd-run --user -p Delegate=yes`), otherwise
+// isAvailable() is false and the watcher's rlimits are all there is.
+class Cgroup {
+  public:
+	~Cgroup();
+
+	static bool isAvailable();
+	static std::unique_ptr<Cgroup> create();
+
+	bool write(const QString &file, const QByteArray &value) const;
+	// A single number file such as memory.peak, or the `key` entry of a
+	// flat keyed file such as cpu.stat. -1 if it cannot be read.
+	qint64 read(const QString &file, const QString &key = QString()) const;
+	// cgroup.procs, opened close-on-exec. The watcher writes "0" to it right
+	// before exec'ing the program, so only the program itself is accounted.
+	int getProcsDescriptor() const;
+	// Kill every process in the cgroup, including anything that forked off
+	void kill() const;
+
+  private:
+	explicit Cgroup(QString path);
+
+	static const QString &delegatedRoot();
+
+	QString path;
+	int procsDescriptor{-1};
+};
+
+#endif
@@ -0,0 +1,213 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "checkerplugin.h"
+#include "base/LemonLog.hpp"
+#include "core/outputreader.h"
+
+#include <QDeadlineTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+#include <array>
+#include <cstring>
+#include <thread>
+
+#define LEMON_MODULE_NAME "CheckerPlugin"
+
+// One call of the checker, shared with its caller, which may outlive the
+// judging thread that gave up on it
+struct CheckerPlugin::Call {
+	Call(const QString &inputFile, const QString &outputFile, const QString &answerFile)
+	    : input(inputFile), output(outputFile), answer(answerFile), inputPath(QFile::encodeName(inputFile)),
+	      outputPath(QFile::encodeName(outputFile)), answerPath(QFile::encodeName(answerFile)) {}
+
+	OutputReader input;
+	OutputReader output;
+	OutputReader answer;
+	QByteArray inputPath;
+	QByteArray outputPath;
+	QByteArray answerPath;
+	int fullScore{};
+
+	// Raised once the checker returned, after the fields below are set
+	StopSignal done;
+	int status{};
+	int score{};
+	std::array<char, 4096> message{};
+};
+
+// A thread calling the checker, kept idle between calls and left to quit
+// once given up on
+struct CheckerPlugin::Caller {
+	QMutex mutex;
+	QWaitCondition wakeUp;
+	std::shared_ptr<Call> call;
+	bool quit{};
+	std::thread thread;
+};
+
+namespace {
+	auto file(const QByteArray &path, const OutputReader &reader) -> CheckerPlugin::File {
+		auto contents = reader.contents();
+		return {path.constData(), contents.data(), contents.size()};
+	}
+} // namespace
+
+CheckerPlugin::CheckerPlugin(const QString &fileName) : library(QFileInfo(fileName).absoluteFilePath()) {
+	if (! library.load()) {
+		error = library.errorString();
+		WARN("Cannot load the checker plugin", fileName, error);
+		return;
+	}
+
+	function = reinterpret_cast<CheckFunction>(library.resolve("lemon_check"));
+
+	if (! function)
+		error = QObject::tr("%1 does not export lemon_check").arg(fileName);
+}
+
+CheckerPlugin::~CheckerPlugin() {
+	for (const auto &caller : idleCallers) {
+		{
+			QMutexLocker locker(&caller->mutex);
+			caller->quit = true;
+			caller->wakeUp.wakeOne();
+		}
+
+		caller->thread.join();
+	}
+}
+
+auto CheckerPlugin::errorString() const -> QString {
+	if (hung)
+		return QObject::tr("The checker exceeded the time limit before and is still running");
+
+	return error;
+}
+
+auto CheckerPlugin::takeCaller() -> std::shared_ptr<Caller> {
+	{
+		QMutexLocker locker(&mutex);
+
+		if (! idleCallers.empty()) {
+			auto caller = std::move(idleCallers.back());
+			idleCallers.pop_back();
+			return caller;
+		}
+	}
+
+	auto caller = std::make_shared<Caller>();
+
+	caller->thread = std::thread([caller, check = function] {
+		QMutexLocker locker(&caller->mutex);
+
+		for (;;) {
+			while (! caller->call && ! caller->quit)
+				caller->wakeUp.wait(&caller->mutex);
+
+			if (! caller->call)
+				return;
+
+			auto call = std::move(caller->call);
+			locker.unlock();
+
+			const File input = file(call->inputPath, call->input);
+			const File output = file(call->outputPath, call->output);
+			const File answer = file(call->answerPath, call->answer);
+			call->status = check(&input, &output, &answer, call->fullScore, &call->score,
+			                     call->message.data(), call->message.size());
+			call->done.raise();
+
+			locker.relock();
+		}
+	});
+
+	return caller;
+}
+
+auto CheckerPlugin::check(const QString &inputFile, const QString &outputFile, const QString &answerFile,
+                          int fullScore, int timeLimit, const StopSignal *stop) -> Result {
+	Result result;
+
+	if (! function || hung) {
+		result.message = errorString();
+		return result;
+	}
+
+	auto call = std::make_shared<Call>(inputFile, outputFile, answerFile);
+
+	if (! call->input.valid() || ! call->output.valid() || ! call->answer.valid()) {
+		result.status = Failed;
+		result.message = QObject::tr("Cannot read the files to check");
+		return result;
+	}
+
+	call->fullScore = fullScore;
+	QDeadlineTimer deadline(timeLimit);
+	auto caller = takeCaller();
+
+	{
+		QMutexLocker locker(&caller->mutex);
+		caller->call = call;
+		caller->wakeUp.wakeOne();
+	}
+
+	if (stop)
+		StopSignal::waitForAny({&call->done, stop}, deadline);
+	else
+		StopSignal::waitForAny({&call->done}, deadline);
+
+	if (! call->done.isRaised()) {
+		// Its thread quits once the checker returns, if ever
+		{
+			QMutexLocker locker(&caller->mutex);
+			caller->quit = true;
+		}
+
+		caller->thread.detach();
+
+		if (deadline.hasExpired()) {
+			hung = true;
+			result.status = TimedOut;
+		} else {
+			// Going on in the background, but soon over unless it hangs
+			result.status = Stopped;
+		}
+
+		return result;
+	}
+
+	{
+		QMutexLocker locker(&mutex);
+		idleCallers.push_back(caller);
+	}
+
+	if (call->status != 0) {
+		result.status = Failed;
+		return result;
+	}
+
+	call->message.back() = '\0';
+	result.status = Checked;
+	result.score = call->score;
+	result.message = QString::fromUtf8(call->message.data());
+	return result;
+}
+
+auto CheckerPlugins::get(const QString &fileName) -> std::shared_ptr<CheckerPlugin> {
+	const QString path = QFileInfo(fileName).absoluteFilePath();
+	QMutexLocker locker(&mutex);
+	auto &plugin = plugins[path];
+
+	if (! plugin)
+		plugin = std::make_shared<CheckerPlugin>(path);
+
+	return plugin;
+}
@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include "processlauncher.h"
+
+#include <QHash>
+#include <QLibrary>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// A special judge built as a shared library instead of a program, loaded once
+// per judge session and called for each test case without starting anything.
+// It exports with C linkage:
+//
+//   struct lemon_file {
+//       const char *path;
+//       const char *data; // The whole file, not NUL-terminated
+//       size_t size;
+//   };
+//
+//   int lemon_check(const struct lemon_file *input, const struct lemon_file *output,
+//                   const struct lemon_file *answer, int full_score, int *score,
+//                   char *message, size_t message_size);
+//
+// which returns 0 once it has set *score and written a NUL-terminated message
+// of at most message_size bytes, anything else if it could not check. It is
+// called from several judging threads at once.
+//
+// Each call runs on a thread kept for the next one, so that a checker that
+// runs over the time limit, which cannot be stopped in the process, is left
+// running there and not called again.
+class CheckerPlugin {
+  public:
+	struct File {
+		const char *path;
+		const char *data;
+		std::size_t size;
+	};
+
+	using CheckFunction = int (*)(const File *, const File *, const File *, int, int *, char *, std::size_t);
+
+	enum Status { Checked, Failed, TimedOut, Stopped, Unusable };
+
+	struct Result {
+		Status status = Unusable;
+		int score = 0;
+		QString message;
+	};
+
+	explicit CheckerPlugin(const QString &fileName);
+	CheckerPlugin(const CheckerPlugin &) = delete;
+	CheckerPlugin &operator=(const CheckerPlugin &) = delete;
+	~CheckerPlugin();
+
+	// Why the checker cannot be called, empty if it can
+	QString errorString() const;
+	Result check(const QString &inputFile, const QString &outputFile, const QString &answerFile,
+	             int fullScore, int timeLimit, const StopSignal *);
+
+  private:
+	struct Call;
+	struct Caller;
+
+	std::shared_ptr<Caller> takeCaller();
+
+	QLibrary library;
+	CheckFunction function{};
+	QString error;
+	std::atomic<bool> hung{false};
+	QMutex mutex;
+	std::vector<std::shared_ptr<Caller>> idleCallers;
+};
+
+// The checker plugins of a judge session, each loaded when first needed
+class CheckerPlugins {
+  public:
+	std::shared_ptr<CheckerPlugin> get(const QString &fileName);
+
+  private:
+	QMutex mutex;
+	QHash<QString, std::shared_ptr<CheckerPlugin>> plugins;
+};
@@ -0,0 +1,205 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "compilecache.h"
+#include "base/LemonLog.hpp"
+#include "core/fieldhash.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <vector>
+
+#define LEMON_MODULE_NAME "CompileCache"
+
+namespace {
+	// Bumped whenever an entry is laid out differently
+	constexpr int formatVersion = 1;
+
+	auto entrySize(const QString &entry) -> qint64 {
+		qint64 size = 0;
+		QDirIterator iterator(entry, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+
+		while (iterator.hasNext())
+			size += iterator.nextFileInfo().size();
+
+		return size;
+	}
+} // namespace
+
+CompileCache::CompileCache(const QString &path, qint64 sizeLimit) : path(path), sizeLimit(sizeLimit) {}
+
+auto CompileCache::defaultPath() -> QString {
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "compile";
+}
+
+auto CompileCache::key(const Job &job) const -> QByteArray {
+	FieldHash hash;
+	hash.addField(QByteArray::number(formatVersion));
+
+	const QDir directory(job.directory);
+	const QStringList files = directory.entryList(QDir::Files | QDir::Hidden, QDir::Name);
+
+	for (const auto &name : files) {
+		QFile file(directory.filePath(name));
+		hash.addField(name.toUtf8());
+
+		if (! hash.addFile(file))
+			return {};
+	}
+
+	hash.addField(job.compiler.toUtf8());
+
+	// A compiler upgraded in place may build differently
+	QFileInfo compiler(QStandardPaths::findExecutable(job.compiler));
+	hash.addField(QByteArray::number(compiler.size()));
+	hash.addField(QByteArray::number(compiler.lastModified().toMSecsSinceEpoch()));
+
+	QStringList environment = job.environment.toStringList();
+	environment.sort();
+
+	for (const auto &variable : std::as_const(environment))
+		hash.addField(variable.toUtf8());
+
+	for (const auto &command : job.commands)
+		hash.addField(command.toUtf8());
+
+	return hash.result();
+}
+
+auto CompileCache::restore(const QByteArray &key, const QString &directory, CompileState &state,
+                           QString &message) -> bool {
+	const QString entry = QDir(path).filePath(QString::fromLatin1(key));
+	QFile result(entry + QDir::separator() + "result");
+
+	if (! result.open(QFile::ReadOnly))
+		return false;
+
+	QDataStream in(&result);
+	int storedState = 0;
+	QString storedMessage;
+	in >> storedState >> storedMessage;
+
+	if (in.status() != QDataStream::Ok)
+		return false;
+
+	const QDir files(entry + QDir::separator() + "files");
+
+	for (const auto &name : files.entryList(QDir::Files | QDir::Hidden)) {
+		const QString target = directory + QDir::separator() + name;
+		QFile::remove(target);
+
+		// Evicted meanwhile, compiled as if it never was there
+		if (! QFile::copy(files.filePath(name), target))
+			return false;
+	}
+
+	// What was used last goes last when the cache is full
+	result.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+
+	state = static_cast<CompileState>(storedState);
+	message = storedMessage;
+	return true;
+}
+
+void CompileCache::store(const QByteArray &key, const QString &directory, const QStringList &inputs,
+                         CompileState state, const QString &message) {
+	// The others depend on how busy the machine is or how the compiler is set
+	if (key.isEmpty() || (state != CompileSuccessfully && state != CompileError))
+		return;
+
+	if (! QDir().mkpath(path))
+		return;
+
+	// Filled first and renamed into place, so that no one sees half of it
+	QTemporaryDir staging(QDir(path).filePath("staging-XXXXXX"));
+
+	if (! staging.isValid() || ! QDir(staging.path()).mkdir("files"))
+		return;
+
+	const QDir source(directory);
+	const QStringList files = source.entryList(QDir::Files | QDir::Hidden);
+
+	for (const auto &name : files) {
+		if (inputs.contains(name))
+			continue;
+
+		if (! QFile::copy(source.filePath(name), staging.filePath("files/" + name)))
+			return;
+	}
+
+	QFile result(staging.filePath("result"));
+
+	if (! result.open(QFile::WriteOnly))
+		return;
+
+	QDataStream out(&result);
+	out << static_cast<int>(state) << message;
+	result.close();
+
+	const qint64 stored = entrySize(staging.path());
+
+	// Another judge may have stored the same compile meanwhile
+	if (! QDir().rename(staging.path(), QDir(path).filePath(QString::fromLatin1(key))))
+		return;
+
+	staging.setAutoRemove(false);
+
+	QMutexLocker locker(&mutex);
+
+	if (size != -1)
+		size += stored;
+
+	if (size == -1 || size > sizeLimit)
+		evict();
+}
+
+// Must be called with `mutex` held. Counts the size of all entries, and
+// removes the least recently used ones while it is over the limit.
+void CompileCache::evict() {
+	struct Entry {
+		QDateTime used;
+		QString path;
+		qint64 size;
+	};
+
+	std::vector<Entry> entries;
+	size = 0;
+
+	const QFileInfoList list = QDir(path).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+	for (const auto &info : list) {
+		if (info.fileName().startsWith("staging-"))
+			continue;
+
+		const QString entry = info.absoluteFilePath();
+		entries.push_back({QFileInfo(entry + QDir::separator() + "result").lastModified(), entry,
+		                   entrySize(entry)});
+		size += entries.back().size;
+	}
+
+	std::sort(entries.begin(), entries.end(),
+	          [](const Entry &a, const Entry &b) { return a.used < b.used; });
+
+	for (const auto &entry : entries) {
+		if (size <= sizeLimit)
+			break;
+
+		if (QDir(entry.path).removeRecursively()) {
+			size -= entry.size;
+			DEBUG("Evicted", entry.path);
+		}
+	}
+}
@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include "base/LemonType.hpp"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QProcessEnvironment>
+#include <QString>
+#include <QStringList>
+
+// Keeps what compiling a contestant's sources left behind, on disk so that it
+// outlives the judge session: judging again, or the same source handed in by
+// someone else, restores the files and the compiler's message instead of
+// compiling. A compile is known by a hash of every file in the directory it
+// runs in, the compiler and its arguments and environment. The entries used
+// least recently go first once the cache grows past its limit.
+//
+// Unlike BuildCache, the files are taken as they are in the directory, and
+// only compiles that succeed or fail on their own account are kept.
+class CompileCache {
+  public:
+	struct Job {
+		// Where the compiler runs, with the sources and all that goes with them
+		QString directory;
+		QString compiler;
+		QProcessEnvironment environment;
+		// The arguments of each run of the compiler
+		QStringList commands;
+	};
+
+	explicit CompileCache(const QString &path = defaultPath(), qint64 sizeLimit = defaultSizeLimit);
+
+	static QString defaultPath();
+
+	// Empty if a file of the job cannot be read
+	QByteArray key(const Job &) const;
+	// Puts the files of the compile known by `key` in `directory`
+	bool restore(const QByteArray &key, const QString &directory, CompileState &, QString &message);
+	// Keeps the files of `directory` that are not `inputs`
+	void store(const QByteArray &key, const QString &directory, const QStringList &inputs, CompileState,
+	           const QString &message);
+
+  private:
+	static constexpr qint64 defaultSizeLimit = qint64(1) << 30;
+
+	QString path;
+	qint64 sizeLimit;
+	QMutex mutex;
+	// Of all entries, -1 until first needed
+	qint64 size{-1};
+
+	void evict();
+};
@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "compilerprofiles.h"
+#include "base/compiler.h"
+
+#include <QStringList>
+
+auto CompilerProfile::findConfiguration(const QString &name) const -> int {
+	return configurations.value(name, 0);
+}
+
+CompilerProfiles::CompilerProfiles(const QList<Compiler *> &compilers) {
+	const QProcessEnvironment system = QProcessEnvironment::systemEnvironment();
+	const QStringList values = system.toStringList();
+
+	for (const auto *compiler : compilers) {
+		CompilerProfile profile;
+		profile.compiler = compiler;
+		profile.environment = compiler->getEnvironment();
+
+		for (const auto &value : values) {
+			int tmp = value.indexOf("=");
+
+			if (tmp == 0)
+				continue;
+
+			QString variable = value.mid(0, tmp);
+			if (profile.environment.contains(variable))
+				// ';' for windows ':' for linux
+				profile.environment.insert(variable, profile.environment.value(variable) +
+#ifdef Q_OS_WIN32
+				                                         ";"
+#else
+				                                         ":"
+#endif
+				                                         + system.value(variable));
+			else
+				profile.environment.insert(variable, system.value(variable));
+		}
+
+		const QStringList &names = compiler->getConfigurationNames();
+
+		// The first of the same name wins, as it did with indexOf()
+		for (int k = names.size() - 1; k >= 0; k--)
+			profile.configurations.insert(names[k], k);
+
+		for (const auto &extension : compiler->getSourceExtensions())
+			if (! extensions[extension].contains(profiles.size()))
+				extensions[extension].append(profiles.size());
+
+		profiles.append(profile);
+	}
+}
+
+auto CompilerProfiles::getProfiles() const -> const QList<CompilerProfile> & { return profiles; }
+
+auto CompilerProfiles::forExtension(const QString &suffix) const -> QList<const CompilerProfile *> {
+	QList<const CompilerProfile *> result;
+
+	for (int index : extensions.value(suffix))
+		result.append(&profiles[index]);
+
+	return result;
+}
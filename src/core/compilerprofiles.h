@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QProcessEnvironment>
+#include <QString>
+
+class Compiler;
+
+// What a compiler needs worked out before it compiles anything
+struct CompilerProfile {
+	const Compiler *compiler{};
+	// The compiler's own variables in front of those of the system
+	QProcessEnvironment environment;
+	QHash<QString, int> configurations;
+
+	// The first configuration if there is none named so
+	int findConfiguration(const QString &name) const;
+};
+
+// The compilers of a judge session, resolved once when it starts and then
+// read by every TaskJudger at the same time. Nothing changes it afterwards.
+class CompilerProfiles {
+  public:
+	explicit CompilerProfiles(const QList<Compiler *> &);
+
+	// In order of priority
+	const QList<CompilerProfile> &getProfiles() const;
+	// Those compiling sources with the extension `suffix`, in order of priority
+	QList<const CompilerProfile *> forExtension(const QString &suffix) const;
+
+  private:
+	QList<CompilerProfile> profiles;
+	QHash<QString, QList<int>> extensions;
+};
@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "fieldhash.h"
+
+#include <QFile>
+
+void FieldHash::addField(const QByteArray &field) {
+	hash.addData(field);
+	hash.addData(QByteArrayView("", 1));
+}
+
+auto FieldHash::addFile(QFile &file) -> bool {
+	if (! file.isOpen() && ! file.open(QFile::ReadOnly))
+		return false;
+
+	addField(QByteArray::number(file.size()));
+	return hash.addData(&file);
+}
+
+auto FieldHash::result() const -> QByteArray { return hash.result().toHex(); }
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QCryptographicHash>
+
+class QFile;
+
+// A SHA-256 over a list of fields, such as the keys of the build and compile
+// caches. Every field ends with a NUL, so that no two lists read the same.
+class FieldHash {
+  public:
+	void addField(const QByteArray &);
+	// The size, then the content; false if it cannot be read
+	bool addFile(QFile &);
+	// Hex encoded
+	QByteArray result() const;
+
+  private:
+	QCryptographicHash hash{QCryptographicHash::Sha256};
+};
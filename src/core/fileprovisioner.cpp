@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "fileprovisioner.h"
+#include "base/LemonLog.hpp"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#ifdef Q_OS_WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define LEMON_MODULE_NAME "FileProvisioner"
+
+auto FileProvisioner::linkFile(const QString &source, const QString &target) -> bool {
+#ifdef Q_OS_WIN32
+	if (CreateHardLinkW(reinterpret_cast<const wchar_t *>(target.utf16()),
+	                    reinterpret_cast<const wchar_t *>(source.utf16()), nullptr))
+		return true;
+#else
+	if (::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0)
+		return true;
+#endif
+
+	return QFile::copy(source, target);
+}
+
+#ifndef Q_OS_WIN32
+
+auto FileProvisioner::watcherFile() -> QString {
+	// Lives until the application exits, taking the extracted watcher with it
+	static QTemporaryDir cacheDir;
+	static const QString path = [] {
+		if (! cacheDir.isValid())
+			return QString();
+
+		QString fileName = cacheDir.filePath("watcher");
+
+		if (! QFile::copy(":/watcher/watcher_unix", fileName)) {
+			WARN("Cannot extract the watcher to", fileName);
+			return QString();
+		}
+
+		QFile::setPermissions(fileName, QFileDevice::ReadOwner | QFileDevice::ExeOwner);
+		return fileName;
+	}();
+
+	return path;
+}
+
+#endif
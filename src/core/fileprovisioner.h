@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include <QString>
+
+// Puts files into the per-case working directories without copying them
+// whenever the platform allows it.
+class FileProvisioner {
+  public:
+	// Hard link `source` to `target`, falling back to QFile::copy (which
+	// already tries a reflink first) across filesystems. The target shares
+	// its storage with the source, so it must not be writable by whatever
+	// runs in the working directory, see ProcessRunner::bindsReadOnlyFiles().
+	static bool linkFile(const QString &source, const QString &target);
+
+#ifndef Q_OS_WIN32
+	// The watcher extracted from the resources once per process, or an empty
+	// string if that failed.
+	static QString watcherFile();
+#endif
+};
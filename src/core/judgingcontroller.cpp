@@ -12,25 +12,82 @@
 
 #define LEMON_MODULE_NAME "JudgingController"
 
-JudgingController::JudgingController(Settings *settings, QObject *parent) : QObject(parent) {
+JudgingController::JudgingController(Settings *settings, QObject *parent)
+    : QObject(parent), compilerProfiles(settings->getCompilerList()) {
 	isJudging = false;
 	maxThreads = qMax(1, settings->getMaxJudgingThreads());
+	const int compileThreads = qMax(1, settings->getMaxCompilingThreads());
+	// Enough for every judging slot to find its next program compiled,
+	// without filling the disk with the binaries of the whole contest
+	lookahead = compileThreads + 2 * maxThreads;
+	pool = new JudgingPool(maxThreads, true, this);
+	checkPool = new JudgingPool(maxThreads, false, this);
+	compilePool = new JudgingPool(compileThreads, false, this);
+	connect(pool, &JudgingPool::workerIdle, this, &JudgingController::assign, Qt::QueuedConnection);
 }
 
+JudgingController::~JudgingController() {
+	pool->shutdown();
+	checkPool->shutdown();
+	compilePool->shutdown();
+	qDeleteAll(queuingTasks);
+}
+
+// Start compiling queued TaskJudgers, as far ahead of the judging slots as
+// `lookahead` allows. A compile error is told as soon as it is known, without
+// waiting for a judging slot.
+void JudgingController::feed() {
+	if (! isJudging) {
+		return;
+	}
+	while (! queuingTasks.empty() && compilingTasks.size() + readyTasks.size() < lookahead) {
+		auto *taskJudger = queuingTasks.front();
+		queuingTasks.pop_front();
+		connect(taskJudger, &TaskJudger::judgingFinished, this, &JudgingController::taskFinished,
+		        Qt::QueuedConnection);
+		connect(taskJudger, &TaskJudger::compiled, this, &JudgingController::taskCompiled,
+		        Qt::QueuedConnection);
+		runningTasks.insert(taskJudger);
+		compilingTasks.insert(taskJudger);
+		taskJudger->setJudgingPool(pool);
+		taskJudger->setCheckPool(checkPool);
+		taskJudger->setCompilePool(compilePool);
+		taskJudger->setAnswerCache(&answerCache);
+		taskJudger->setVerdictCache(&verdictCache);
+		taskJudger->setCheckerPlugins(&checkerPlugins);
+		taskJudger->setBuildCache(&buildCache);
+		taskJudger->setCompileCache(&compileCache);
+		taskJudger->setCompilerProfiles(&compilerProfiles);
+		taskJudger->compileIt();
+	}
+}
+
+// Activate compiled TaskJudgers while the pool does not have enough work to
+// keep every slot busy. A TaskJudger only feeds the pool with its own test
+// cases, so one more contestant/task is started whenever a worker runs dry.
 void JudgingController::assign() {
 	if (! isJudging) {
 		return;
 	}
-	if (queuingTasks.empty())
+	while (! readyTasks.empty() && pool->getPendingCount() < maxThreads) {
+		readyTasks.front()->judgeIt();
+		readyTasks.pop_front();
+	}
+	feed();
+}
+
+void JudgingController::taskCompiled() {
+	auto *taskJudger = qobject_cast<TaskJudger *>(sender());
+	if (taskJudger == nullptr || ! compilingTasks.remove(taskJudger)) {
+		return;
+	}
+	// Stopped meanwhile, it only has to finish
+	if (! isJudging) {
+		taskJudger->judgeIt();
 		return;
-	QThread *thread = new QThread;
-	auto *taskJudger = queuingTasks.front();
-	queuingTasks.pop_front();
-	taskJudger->moveToThread(thread);
-	connect(taskJudger, &TaskJudger::judgingFinished, this, &JudgingController::taskFinished);
-	runningTasks[taskJudger] = thread;
-	thread->start();
-	QMetaObject::invokeMethod(taskJudger, &TaskJudger::judgeIt);
+	}
+	readyTasks.push_back(taskJudger);
+	assign();
 }
 
 void JudgingController::taskFinished() {
@@ -38,12 +95,8 @@ void JudgingController::taskFinished() {
 	if (taskJudger == nullptr) {
 		return;
 	}
-	if (runningTasks.count(taskJudger)) {
-		auto *thread = runningTasks[taskJudger];
-		thread->quit();
-		thread->wait();
-		delete thread;
-		runningTasks.remove(taskJudger);
+	compilingTasks.remove(taskJudger);
+	if (runningTasks.remove(taskJudger)) {
 		delete taskJudger;
 	}
 	assign();
@@ -58,16 +111,19 @@ void JudgingController::start() {
 		return;
 	}
 	isJudging = true;
-	while (! queuingTasks.empty() && runningTasks.size() < maxThreads) {
-		assign();
-	}
+	feed();
 }
 void JudgingController::stop() {
 	if (! isJudging)
 		return;
 	isJudging = false;
-	for (auto [taskJudger, thread] : runningTasks.toStdMap()) {
-		QMetaObject::invokeMethod(taskJudger, &TaskJudger::stop);
+	for (auto *taskJudger : std::as_const(runningTasks)) {
+		taskJudger->stop();
+	}
+	// Those compiled but not started finish at once
+	while (! readyTasks.empty()) {
+		readyTasks.front()->judgeIt();
+		readyTasks.pop_front();
 	}
 	// emit judgeFinished();
 }
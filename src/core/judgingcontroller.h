@@ -7,29 +7,58 @@
 #pragma once
 
 #include "base/LemonType.hpp"
+#include "answercache.h"
 #include "base/settings.h"
+#include "buildcache.h"
+#include "checkerplugin.h"
+#include "compilecache.h"
+#include "compilerprofiles.h"
+#include "judgingpool.h"
 #include "taskjudger.h"
+#include "verdictcache.h"
 
-#include <QMap>
-#include <QMutex>
 #include <QObject>
 #include <QQueue>
-#include <QThread>
+#include <QSet>
 
 class JudgingController : public QObject {
 	Q_OBJECT
 
   public:
 	explicit JudgingController(Settings *settings, QObject *parent = nullptr);
+	~JudgingController() override;
 	void addTask(TaskJudger *judger);
 
   private:
 	QQueue<TaskJudger *> queuingTasks;
-	QMap<TaskJudger *, QThread *> runningTasks;
+	// Compiling, then compiled and waiting for a judging slot
+	QSet<TaskJudger *> compilingTasks;
+	QQueue<TaskJudger *> readyTasks;
+	QSet<TaskJudger *> runningTasks;
+	JudgingPool *pool;
+	// Judges the outputs of the programs run by `pool`, with as many workers
+	// so that checking is never less parallel than on the judging slots
+	JudgingPool *checkPool;
+	// Compiles ahead of `pool`, its own number of threads set by the user
+	JudgingPool *compilePool;
+	// Standard outputs shared by everyone judged in this session
+	AnswerCache answerCache;
+	VerdictCache verdictCache;
+	CheckerPlugins checkerPlugins;
+	// Special judges and graders built from source
+	BuildCache buildCache;
+	// Contestants' compiles, kept on disk for the sessions to come
+	CompileCache compileCache;
+	// The compilers as they were when the session started
+	const CompilerProfiles compilerProfiles;
 	bool isJudging;
 	int maxThreads;
+	// How many may be compiling or compiled but not running at once
+	int lookahead;
+	void feed();
   public slots:
 	void stop();
+	void taskCompiled();
 	void taskFinished();
 	void assign();
 	void start();
@@ -0,0 +1,149 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "judgingpool.h"
+
+#ifdef Q_OS_LINUX
+#include "core/sandboxzygote.h"
+
+#include <optional>
+#endif
+
+#define LEMON_MODULE_NAME "JudgingPool"
+
+JudgingWorker::JudgingWorker(JudgingPool *pool, int index, bool runsPrograms)
+    : pool(pool), index(index), runsPrograms(runsPrograms) {}
+
+void JudgingWorker::run() {
+#ifdef Q_OS_LINUX
+	// Ready before the first test case arrives, used by every ProcessRunner
+	// on this thread
+	std::optional<SandboxZygote> zygote;
+
+	if (runsPrograms)
+		zygote.emplace();
+#endif
+
+	// Told once each time this worker runs out of work, not on every wake up
+	bool busy = false;
+
+	while (true) {
+		JudgingPool::Job job;
+
+		if (pool->take(index, job)) {
+			job();
+			busy = true;
+			continue;
+		}
+
+		if (busy) {
+			busy = false;
+			emit pool->workerIdle();
+		}
+
+		QMutexLocker locker(&pool->sleepMutex);
+
+		if (pool->quit)
+			return;
+
+		// A job may have been submitted between take() and locking, re-check
+		// before going to sleep so that the wake up is not lost.
+		if (pool->pendingCount > 0)
+			continue;
+
+		pool->wakeUp.wait(&pool->sleepMutex);
+	}
+}
+
+JudgingPool::JudgingPool(int workerCount, bool runsPrograms, QObject *parent) : QObject(parent) {
+	workerCount = qMax(1, workerCount);
+
+	for (int i = 0; i < workerCount; i++)
+		queues.push_back(std::make_unique<JobQueue>());
+
+	for (int i = 0; i < workerCount; i++) {
+		auto *worker = new JudgingWorker(this, i, runsPrograms);
+		workers.append(worker);
+		worker->start();
+	}
+}
+
+JudgingPool::~JudgingPool() {
+	shutdown();
+	qDeleteAll(workers);
+}
+
+auto JudgingPool::getWorkerCount() const -> int { return static_cast<int>(queues.size()); }
+
+auto JudgingPool::getPendingCount() const -> int { return pendingCount; }
+
+auto JudgingPool::nextQueue() -> int { return queueCounter++ % getWorkerCount(); }
+
+void JudgingPool::submit(int queue, Job job) {
+	{
+		auto &target = *queues[queue % getWorkerCount()];
+		QMutexLocker locker(&target.mutex);
+		target.jobs.push_back(std::move(job));
+		++pendingCount;
+	}
+
+	// One job wants one worker; those awake re-check before they sleep
+	QMutexLocker locker(&sleepMutex);
+	wakeUp.wakeOne();
+}
+
+// Drop the queued jobs and wait for the running ones. Callers are expected to
+// have stopped the TaskJudgers first, otherwise this blocks until their
+// current test cases finish.
+void JudgingPool::shutdown() {
+	for (auto &queue : queues) {
+		QMutexLocker locker(&queue->mutex);
+		pendingCount -= static_cast<int>(queue->jobs.size());
+		queue->jobs.clear();
+	}
+
+	{
+		QMutexLocker locker(&sleepMutex);
+		quit = true;
+		wakeUp.wakeAll();
+	}
+
+	for (auto *worker : std::as_const(workers))
+		worker->wait();
+}
+
+// Own queue first in FIFO order, so that a TaskJudger's test cases run in the
+// order they were submitted; otherwise steal the newest job of another worker.
+auto JudgingPool::take(int index, Job &job) -> bool {
+	{
+		auto &own = *queues[index];
+		QMutexLocker locker(&own.mutex);
+
+		if (! own.jobs.empty()) {
+			job = std::move(own.jobs.front());
+			own.jobs.pop_front();
+			--pendingCount;
+			return true;
+		}
+	}
+
+	const int count = getWorkerCount();
+
+	for (int k = 1; k < count; k++) {
+		auto &victim = *queues[(index + k) % count];
+		QMutexLocker locker(&victim.mutex);
+
+		if (! victim.jobs.empty()) {
+			job = std::move(victim.jobs.back());
+			victim.jobs.pop_back();
+			--pendingCount;
+			return true;
+		}
+	}
+
+	return false;
+}
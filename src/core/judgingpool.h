@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class JudgingPool;
+
+class JudgingWorker : public QThread {
+	Q_OBJECT
+  public:
+	JudgingWorker(JudgingPool *pool, int index, bool runsPrograms);
+
+  protected:
+	void run() override;
+
+  private:
+	JudgingPool *pool;
+	int index;
+	bool runsPrograms;
+};
+
+// A fixed set of judging slots shared by every TaskJudger of a judge session.
+//
+// Each worker owns a job queue. A TaskJudger always submits to the same queue
+// (see nextQueue()), so its test cases tend to stay on one worker in order;
+// a worker that runs dry steals from the back of the other queues, which keeps
+// every slot busy when only a few contestants are left.
+//
+// A session has three of them: one running the programs, whose size is the
+// number of judging threads set by the user, one checking their outputs and
+// one compiling, with its own number of threads. The workers of the last two
+// never run a program under the watcher.
+class JudgingPool : public QObject {
+	Q_OBJECT
+  public:
+	using Job = std::function<void()>;
+
+	explicit JudgingPool(int workerCount, bool runsPrograms = true, QObject *parent = nullptr);
+	~JudgingPool() override;
+
+	int getWorkerCount() const;
+	int getPendingCount() const;
+	int nextQueue();
+	void submit(int queue, Job job);
+	void shutdown();
+
+  private:
+	friend class JudgingWorker;
+
+	struct JobQueue {
+		QMutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<JobQueue>> queues;
+	QList<JudgingWorker *> workers;
+	QMutex sleepMutex;
+	QWaitCondition wakeUp;
+	std::atomic<int> pendingCount{0};
+	std::atomic<int> queueCounter{0};
+	bool quit{false};
+
+	bool take(int index, Job &job);
+
+  signals:
+	void workerIdle();
+};
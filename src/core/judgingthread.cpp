@@ -11,9 +11,13 @@
 #include "LemonType.hpp"
 #include "base/LemonLog.hpp"
 #include "base/settings.h"
+#include "core/answercache.h"
+#include "core/batchchecker.h"
+#include "core/checkerplugin.h"
+#include "core/outputreader.h"
 #include "core/task.h"
+#include "core/verdictcache.h"
 
-#include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
@@ -22,18 +26,26 @@
 #include <QTextStream>
 #include <QTime>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #define LEMON_MODULE_NAME "JudgingThread"
 
-JudgingThread::JudgingThread(QObject *parent) : QThread(parent) {
-	moveToThread(this);
+JudgingThread::JudgingThread(QObject *parent) : QObject(parent) {
 	// checkRejudgeMode = false;
 	needRejudge = false;
-	stopJudging = false;
 	timeUsed = -1;
 	memoryUsed = -1;
 	judgedTimes = 0;
@@ -52,8 +64,12 @@ void JudgingThread::setEnvironment(const QProcessEnvironment &env) { environment
 
 void JudgingThread::setWorkingDirectory(const QString &directory) { workingDirectory = directory; }
 
+void JudgingThread::setSpecialJudge(const QString &fileName) { specialJudge = fileName; }
+
 void JudgingThread::setSpecialJudgeTimeLimit(int limit) { specialJudgeTimeLimit = limit; }
 
+void JudgingThread::setInteractor(const QString &fileName) { interactor = fileName; }
+
 void JudgingThread::setExecutableFile(const QString &fileName) { executableFile = fileName; }
 
 void JudgingThread::setArguments(const QString &argumentsList) { arguments = argumentsList; }
@@ -80,6 +96,18 @@ void JudgingThread::setRawMemoryLimit(int limit) { rawMemoryLimit = limit; }
 
 void JudgingThread::setInterpreterAsWatcher(bool use) { interpreterAsWatcher = use; }
 
+void JudgingThread::setRunInShell(bool use) { runInShell = use; }
+
+void JudgingThread::setReadOnlyFiles(const QStringList &files) { readOnlyFiles = files; }
+
+void JudgingThread::setAnswerCache(AnswerCache *cache) { answerCache = cache; }
+
+void JudgingThread::setVerdictCache(VerdictCache *cache) { verdictCache = cache; }
+
+void JudgingThread::setCheckerPlugins(CheckerPlugins *plugins) { checkerPlugins = plugins; }
+
+void JudgingThread::setBatchChecker(BatchChecker *checker) { batchChecker = checker; }
+
 auto JudgingThread::getTimeUsed() const -> int { return timeUsed; }
 
 auto JudgingThread::getMemoryUsed() const -> qint64 { return memoryUsed; }
@@ -96,130 +124,146 @@ auto JudgingThread::getMessage() const -> const QString & { return message; }
 
 auto JudgingThread::getNeedRejudge() const -> bool { return needRejudge; }
 
-void JudgingThread::stopJudgingSlot() { stopJudging = true; }
-
-// Chunked file reader used by the line/space comparators below.
-//
-// nextUntilNewLine() / nextUntilSpace() return at most 32 chars per call --
-// they do NOT truncate a long line; callers must loop until eof() to consume
-// the whole line/token. The 32-byte cap keeps `result` (a fixed-capacity
-// std::string reserved at 32) from reallocating, which is the hot path of
-// per-test-case comparison.
-class BufferedStreamReader {
-
-  public:
-	static const int BUFFER_SIZE = 1 << 18; // 128 KiB
-	explicit BufferedStreamReader(const char *filename) : file(fopen(filename, "r")) {
-		result.reserve(32);
-		// Start with bufPos == bufEnd so the first peekChar() triggers an
-		// fread; avoids a separate "primed?" flag.
-		bufPos = buffer + BUFFER_SIZE;
-		bufEnd = buffer + BUFFER_SIZE;
-		lineNumber = 1;
-		isEof = 0;
-	}
-
-	BufferedStreamReader(const BufferedStreamReader &) = delete;
-	BufferedStreamReader &operator=(const BufferedStreamReader &) = delete;
-
-	~BufferedStreamReader() {
-		if (file)
-			fclose(file);
-	}
-
-  private:
-	FILE *file;
-	char buffer[BUFFER_SIZE], *bufEnd, *bufPos;
-	bool isEof;
-	int lineNumber;
-	std::string result; // Fixed Length String,Optimize for speed
-	auto peekChar() -> char;
-	void tryNextLine();
-
-  public:
-	auto valid() const -> bool { return file != nullptr; }
-	auto eof() const -> bool { return isEof; }
-	auto line() const -> int { return lineNumber; }
-	auto nextUntilNewLine() -> std::string_view;
-	auto nextUntilSpace() -> std::string_view;
-};
-
-auto BufferedStreamReader::peekChar() -> char {
-	if (isEof) {
-		return '\0';
-	}
-	if (bufPos == bufEnd) {
-		// Buffer drained -- refill. fread returning 0 means real EOF; latch it
-		// so further peekChar() calls short-circuit without touching the FILE*.
-		bufPos = buffer;
-		bufEnd = buffer + fread(buffer, 1, BUFFER_SIZE, file);
-		if (bufPos == bufEnd) {
-			isEof = true;
-			return '\0';
-		}
-	}
-	return *bufPos;
-}
+auto JudgingThread::hasOutputToCheck() const -> bool { return ! outputToCheck.isEmpty(); }
 
-// Consume one line terminator (\n, \r, or \r\n) if the cursor sits on one,
-// and bump lineNumber. Idempotent when not on a terminator -- safe to call
-// before each token read.
-void BufferedStreamReader::tryNextLine() {
-	char c = peekChar();
-	if (c != '\r' && c != '\n')
-		return;
-	if (c == '\r')
-		bufPos++;
-	c = peekChar();
-	if (c == '\n')
-		bufPos++;
-	lineNumber++;
+void JudgingThread::stopJudgingSlot() {
+	stopJudging.raise();
+	stopProgram.raise();
 }
 
-// Read up to 32 chars from the current position, stopping at any line
-// terminator or EOF. Does NOT consume the terminator -- the next call to
-// tryNextLine() (invoked at the top here) will. Returning a chunk shorter
-// than 32 chars is the signal that the caller has reached end-of-line/EOF;
-// otherwise the caller must call again to read the rest of a long line.
-auto BufferedStreamReader::nextUntilNewLine() -> std::string_view {
-	result.clear();
-	tryNextLine();
-	for (int i = 0; i < 32; i++) {
-		char c = peekChar();
-		if (c == '\n' || c == '\r' || eof())
-			break;
-		result.push_back(c);
-		bufPos++;
+namespace {
+	// The chunks are raw bytes of the files, up to a NUL as before
+	auto chunkText(std::string_view chunk) -> QString {
+		if (chunk.empty())
+			return QString("");
+
+		return QString::fromUtf8(chunk.data(), static_cast<qsizetype>(strnlen(chunk.data(), chunk.size())));
 	}
-	return result;
-}
 
-// Skip leading whitespace (advancing lineNumber across newlines), then read
-// up to 32 non-space chars. Same chunked-read contract as nextUntilNewLine:
-// short return means token end; long tokens must be read across multiple
-// calls. Returns an empty view at EOF.
-auto BufferedStreamReader::nextUntilSpace() -> std::string_view {
-	result.clear();
-	for (char c = peekChar(); std::isspace(c) && ! eof(); c = peekChar())
-		if (c == '\r' || c == '\n')
-			tryNextLine();
-		else
-			bufPos++;
-	if (eof())
+	// The options of GNU diff that compareWithDiff() handles itself
+	struct DiffOptions {
+		bool ignoreSpaceChange{};
+		bool ignoreAllSpace{};
+		bool stripTrailingCr{};
+		bool text{};
+	};
+
+	// Whitespace for diff: what isspace() accepts, except the newline
+	auto isDiffSpace(char c) -> bool { return c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r'; }
+
+	// A line without its '\n' as diff compares it: whitespace removed for
+	// --ignore-all-space, trailing whitespace removed and the rest collapsed
+	// into single spaces for --ignore-space-change
+	auto normalizeLine(std::string_view line, const DiffOptions &options) -> std::string {
+		std::string result;
+		result.reserve(line.size());
+
+		for (std::size_t i = 0; i < line.size(); i++) {
+			if (! isDiffSpace(line[i])) {
+				result += line[i];
+				continue;
+			}
+
+			while (i + 1 < line.size() && isDiffSpace(line[i + 1]))
+				i++;
+
+			if (! options.ignoreAllSpace && i + 1 < line.size())
+				result += ' ';
+		}
+
 		return result;
-	for (int i = 0; i < 32; i++) {
-		char c = peekChar();
-		if (std::isspace(c) || eof())
-			break;
-		result.push_back(c);
-		bufPos++;
 	}
-	return result;
+
+	// Whether diff would see two lines as the same. `complete` is whether a
+	// line ends with a '\n', which only the whitespace options ignore.
+	auto diffLinesEqual(std::string_view a, bool aComplete, std::string_view b, bool bComplete,
+	                    const DiffOptions &options) -> bool {
+		if (options.ignoreAllSpace || options.ignoreSpaceChange)
+			return a == b || normalizeLine(a, options) == normalizeLine(b, options);
+
+		if (options.stripTrailingCr) {
+			if (aComplete && ! a.empty() && a.back() == '\r')
+				a.remove_suffix(1);
+			if (bComplete && ! b.empty() && b.back() == '\r')
+				b.remove_suffix(1);
+		}
+
+		return aComplete == bComplete && a == b;
+	}
+
+	// The next line of `contents` from `pos` on, false at the end
+	auto nextDiffLine(std::string_view contents, std::size_t &pos, std::string_view &line, bool &complete)
+	    -> bool {
+		if (pos >= contents.size())
+			return false;
+
+		std::size_t end = contents.find('\n', pos);
+		complete = end != std::string_view::npos;
+
+		if (! complete)
+			end = contents.size();
+
+		line = contents.substr(pos, end - pos);
+		pos = end + 1;
+		return true;
+	}
+
+	auto parseDiffArguments(const QStringList &arguments, DiffOptions &options) -> bool {
+		for (const auto &argument : arguments) {
+			if (argument == "--ignore-space-change") {
+				options.ignoreSpaceChange = true;
+			} else if (argument == "--ignore-all-space") {
+				options.ignoreAllSpace = true;
+			} else if (argument == "--strip-trailing-cr") {
+				options.stripTrailingCr = true;
+			} else if (argument == "--text") {
+				options.text = true;
+			} else if (argument == "--brief") {
+			} else if (argument.size() > 1 && argument[0] == '-' && argument[1] != '-') {
+				for (auto c : argument.mid(1)) {
+					if (c == 'b')
+						options.ignoreSpaceChange = true;
+					else if (c == 'w')
+						options.ignoreAllSpace = true;
+					else if (c == 'a')
+						options.text = true;
+					else if (c != 'q')
+						return false;
+				}
+			} else {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// The score in the message of a testlib checker or interactor, -1 if it
+	// failed itself
+	auto testlibScore(const QString &message, int fullScore) -> int {
+		if (message.startsWith("FAIL"))
+			return -1;
+
+		QRegularExpressionMatch m = QRegularExpression(R"(^partially correct \((\d+)\))").match(message);
+		if (m.hasMatch())
+			return m.captured(1).toInt() * fullScore / 100;
+
+		m = QRegularExpression(R"(^points ([0-9]*\.[0-9]+|[0-9]+))").match(message);
+		if (m.hasMatch())
+			return static_cast<int>(m.captured(1).toDouble() * fullScore);
+
+		return message.startsWith("ok") ? fullScore : 0;
+	}
+} // namespace
+
+// The standard output, from the answer cache if it keeps it
+auto JudgingThread::readStandardOutput() -> OutputReader {
+	const auto contents = answerCache ? answerCache->contents(outputFile) : nullptr;
+	return contents ? OutputReader(*contents) : OutputReader(outputFile);
 }
 
-void JudgingThread::compareLineByLine(const QString &contestantOutput) {
-	BufferedStreamReader contestantReader(contestantOutput.toLocal8Bit().data());
-	BufferedStreamReader standardOutputReader(outputFile.toLocal8Bit().data());
+void JudgingThread::compareLineByLine(OutputReader &contestantReader) {
+	OutputReader standardOutputReader = readStandardOutput();
 
 	if (! contestantReader.valid()) {
 		score = 0;
@@ -236,6 +280,7 @@ void JudgingThread::compareLineByLine(const QString &contestantOutput) {
 	}
 
 	while (true) {
+		contestantReader.skipEqualLines(standardOutputReader);
 		auto contestantLine = contestantReader.nextUntilNewLine();
 		auto standardOutputLine = standardOutputReader.nextUntilNewLine();
 
@@ -259,8 +304,8 @@ void JudgingThread::compareLineByLine(const QString &contestantOutput) {
 			score = 0;
 			result = WrongAnswer;
 			message = tr(R"(On line %3, Read "%1" but expect "%2")")
-			              .arg(contestantLine.data())
-			              .arg(standardOutputLine.data())
+			              .arg(chunkText(contestantLine))
+			              .arg(chunkText(standardOutputLine))
 			              .arg(contestantReader.line());
 			return;
 		}
@@ -273,9 +318,8 @@ void JudgingThread::compareLineByLine(const QString &contestantOutput) {
 	result = CorrectAnswer;
 }
 
-void JudgingThread::compareIgnoreSpaces(const QString &contestantOutput) {
-	BufferedStreamReader contestantReader(contestantOutput.toLocal8Bit().data());
-	BufferedStreamReader standardOutputReader(outputFile.toLocal8Bit().data());
+void JudgingThread::compareIgnoreSpaces(OutputReader &contestantReader) {
+	OutputReader standardOutputReader = readStandardOutput();
 
 	if (! contestantReader.valid()) {
 		score = 0;
@@ -292,6 +336,7 @@ void JudgingThread::compareIgnoreSpaces(const QString &contestantOutput) {
 	}
 
 	while (true) {
+		contestantReader.skipEqualTokens(standardOutputReader);
 		auto contestantLine = contestantReader.nextUntilSpace();
 		auto standardOutputLine = standardOutputReader.nextUntilSpace();
 
@@ -326,8 +371,8 @@ void JudgingThread::compareIgnoreSpaces(const QString &contestantOutput) {
 			score = 0;
 			result = WrongAnswer;
 			message = tr(R"(On line %3, Read "%1" but expect "%2")")
-			              .arg(contestantLine.data())
-			              .arg(standardOutputLine.data())
+			              .arg(chunkText(contestantLine))
+			              .arg(chunkText(standardOutputLine))
 			              .arg(contestantReader.line());
 			return;
 		}
@@ -337,38 +382,163 @@ void JudgingThread::compareIgnoreSpaces(const QString &contestantOutput) {
 	result = CorrectAnswer;
 }
 
-void JudgingThread::compareWithDiff(const QString &contestantOutput) {
-	QString cmd = diffPath;
-	QStringList cmdArgs =
-	    (QStringList(task->getDiffArguments())
-	     << QFileInfo(outputFile).absoluteFilePath().replace('/', QDir::separator()) << contestantOutput);
+void JudgingThread::compareBinary(const QString &contestantOutput) {
+	OutputReader contestantReader(contestantOutput);
+	OutputReader standardOutputReader = readStandardOutput();
 
-	if (QProcess::execute(cmd, cmdArgs) != 0) {
+	if (! contestantReader.valid()) {
+		score = 0;
+		result = FileError;
+		message = tr(R"(Cannot open contestant's output file)");
+		return;
+	}
+
+	if (! standardOutputReader.valid()) {
+		score = 0;
+		result = FileError;
+		message = tr(R"(Cannot open standard output file)");
+		return;
+	}
+
+	auto contestantBytes = contestantReader.contents();
+	auto standardOutputBytes = standardOutputReader.contents();
+	std::size_t length = qMin(contestantBytes.size(), standardOutputBytes.size());
+	std::size_t position =
+	    OutputReader::firstMismatch(contestantBytes.data(), standardOutputBytes.data(), length);
+
+	if (position < length) {
+		uint contestantByte = static_cast<uchar>(contestantBytes[position]);
+		uint standardOutputByte = static_cast<uchar>(standardOutputBytes[position]);
 		score = 0;
 		result = WrongAnswer;
-	} else {
-		score = fullScore;
-		result = CorrectAnswer;
+		message = tr(R"(On byte %3, Read 0x%1 but expect 0x%2)")
+		              .arg(contestantByte, 2, 16, QChar('0'))
+		              .arg(standardOutputByte, 2, 16, QChar('0'))
+		              .arg(position + 1);
+		return;
+	}
+
+	if (contestantBytes.size() < standardOutputBytes.size()) {
+		score = 0;
+		result = WrongAnswer;
+		message = tr(R"(On byte %1, Contestant's output has less contents)").arg(length + 1);
+		return;
 	}
+
+	if (contestantBytes.size() > standardOutputBytes.size()) {
+		score = 0;
+		result = OutputLimitExceeded;
+		message = tr(R"(On byte %1, Contestant's output has too much contents)").arg(length + 1);
+		return;
+	}
+
+	score = fullScore;
+	result = CorrectAnswer;
 }
 
-void JudgingThread::compareRealNumbers(const QString &contestantOutput) {
-	FILE *contestantOutputFile = fopen(contestantOutput.toLocal8Bit().data(), "r");
+void JudgingThread::compareWithDiff(const QString &contestantOutput) {
+	QStringList arguments = QProcess::splitCommand(task->getDiffArguments());
+	DiffOptions options;
+	OutputReader contestantReader(contestantOutput);
+	OutputReader standardOutputReader = readStandardOutput();
+	auto contestantBytes = contestantReader.contents();
+	auto standardOutputBytes = standardOutputReader.contents();
+
+	// diff only compares files with a NUL in them as a whole, unless --text
+	bool text = contestantBytes.find('\0') == std::string_view::npos &&
+	            standardOutputBytes.find('\0') == std::string_view::npos;
+
+	// The usual options are done here instead of starting diff for each test
+	// case, anything else still goes to the tool
+	if (! parseDiffArguments(arguments, options) || ! contestantReader.valid() ||
+	    ! standardOutputReader.valid() || ! (options.text || text)) {
+		QString cmd = diffPath;
+		QStringList cmdArgs =
+		    (arguments << QFileInfo(outputFile).absoluteFilePath().replace('/', QDir::separator())
+		               << contestantOutput);
+
+		if (QProcess::execute(cmd, cmdArgs) != 0) {
+			score = 0;
+			result = WrongAnswer;
+		} else {
+			score = fullScore;
+			result = CorrectAnswer;
+		}
+
+		return;
+	}
+
+	// Whole lines before the first differing byte are the same
+	std::size_t length = qMin(contestantBytes.size(), standardOutputBytes.size());
+	std::size_t position =
+	    OutputReader::firstMismatch(contestantBytes.data(), standardOutputBytes.data(), length);
+	std::size_t lineStart = contestantBytes.substr(0, position).rfind('\n');
+	lineStart = lineStart == std::string_view::npos ? 0 : lineStart + 1;
+	auto lineNumber =
+	    static_cast<int>(std::count(contestantBytes.begin(), contestantBytes.begin() + lineStart, '\n'));
+	std::size_t contestantPos = lineStart;
+	std::size_t standardOutputPos = lineStart;
+
+	while (true) {
+		std::string_view contestantLine;
+		std::string_view standardOutputLine;
+		bool contestantComplete = false;
+		bool standardOutputComplete = false;
+		bool contestantHasLine =
+		    nextDiffLine(contestantBytes, contestantPos, contestantLine, contestantComplete);
+		bool standardOutputHasLine =
+		    nextDiffLine(standardOutputBytes, standardOutputPos, standardOutputLine, standardOutputComplete);
+		lineNumber++;
+
+		if (! contestantHasLine && ! standardOutputHasLine)
+			break;
+
+		if (! contestantHasLine) {
+			score = 0;
+			result = WrongAnswer;
+			message = tr(R"(On line %1, Contestant's output has less contents)").arg(lineNumber);
+			return;
+		}
+
+		if (! standardOutputHasLine) {
+			score = 0;
+			result = OutputLimitExceeded;
+			message = tr(R"(On line %1, Contestant's output has too much contents)").arg(lineNumber);
+			return;
+		}
 
-	if (contestantOutputFile == nullptr) {
+		if (! diffLinesEqual(contestantLine, contestantComplete, standardOutputLine, standardOutputComplete,
+		                     options)) {
+			score = 0;
+			result = WrongAnswer;
+			message = tr(R"(On line %3, Read "%1" but expect "%2")")
+			              .arg(chunkText(contestantLine.substr(0, 32)))
+			              .arg(chunkText(standardOutputLine.substr(0, 32)))
+			              .arg(lineNumber);
+			return;
+		}
+	}
+
+	score = fullScore;
+	result = CorrectAnswer;
+}
+
+void JudgingThread::compareRealNumbers(OutputReader &contestantReader) {
+	if (! contestantReader.valid()) {
 		score = 0;
 		result = FileError;
 		message = tr(R"(Cannot open contestant's output file)");
 		return;
 	}
 
-	FILE *standardOutputFile = fopen(outputFile.toLocal8Bit().data(), "r");
+	// Parsed once for all contestants if the answer cache keeps it
+	const auto numbers = answerCache ? answerCache->realNumbers(outputFile) : nullptr;
+	OutputReader standardOutputReader(numbers ? QString() : outputFile);
 
-	if (standardOutputFile == nullptr) {
+	if (! numbers && ! standardOutputReader.valid()) {
 		score = 0;
 		result = FileError;
 		message = tr(R"(Cannot open standard output file)");
-		fclose(contestantOutputFile);
 		return;
 	}
 
@@ -381,18 +551,26 @@ void JudgingThread::compareRealNumbers(const QString &contestantOutput) {
 	long double b = NAN;
 	int nowRow = 1;
 
-	while (true) {
-		int cnt1 = fscanf(contestantOutputFile, "%Lf", &a);
-		int cnt2 = fscanf(standardOutputFile, "%Lf", &b);
-
-		char temps = fgetc(standardOutputFile);
+	for (int count = 1;; count++) {
+		int cnt1 = contestantReader.nextReal(a);
+		int cnt2 = 0;
+		char temps = 0;
+
+		if (! numbers) {
+			cnt2 = standardOutputReader.nextReal(b);
+			temps = static_cast<char>(standardOutputReader.nextChar());
+		} else if (auto index = static_cast<std::size_t>(count - 1); index < numbers->values.size()) {
+			cnt2 = 1;
+			b = numbers->values[index];
+			temps = numbers->next[index];
+		} else {
+			cnt2 = numbers->end;
+		}
 
 		if (cnt1 == 0) {
 			score = 0;
 			result = WrongAnswer;
 			message = tr(R"(On line %1, Invalid characters in contestant's output file)").arg(nowRow);
-			fclose(contestantOutputFile);
-			fclose(standardOutputFile);
 			return;
 		}
 
@@ -400,8 +578,6 @@ void JudgingThread::compareRealNumbers(const QString &contestantOutput) {
 			score = 0;
 			result = FileError;
 			message = tr(R"(On line %1, Invalid characters in standard output file)").arg(nowRow);
-			fclose(contestantOutputFile);
-			fclose(standardOutputFile);
 			return;
 		}
 
@@ -412,8 +588,6 @@ void JudgingThread::compareRealNumbers(const QString &contestantOutput) {
 			score = 0;
 			result = WrongAnswer;
 			message = tr(R"(On line %1, Contestant's Output has less contents)").arg(nowRow);
-			fclose(contestantOutputFile);
-			fclose(standardOutputFile);
 			return;
 		}
 
@@ -421,8 +595,6 @@ void JudgingThread::compareRealNumbers(const QString &contestantOutput) {
 			score = 0;
 			result = OutputLimitExceeded;
 			message = tr(R"(On line %1, Contestant's Output has too much contents)").arg(nowRow);
-			fclose(contestantOutputFile);
-			fclose(standardOutputFile);
 			return;
 		}
 
@@ -434,18 +606,12 @@ void JudgingThread::compareRealNumbers(const QString &contestantOutput) {
 			              .arg(a, 0, 'g', 18)
 			              .arg(b, 0, 'g', 18)
 			              .arg(nowRow);
-			fclose(contestantOutputFile);
-			fclose(standardOutputFile);
 			return;
 		}
 
-		QCoreApplication::processEvents();
-
-		if (stopJudging) {
-			fclose(contestantOutputFile);
-			fclose(standardOutputFile);
+		// Checking on every number would cost more than reading it
+		if (count % 4096 == 0 && stopJudging)
 			return;
-		}
 
 		if (temps == '\r' || temps == '\n')
 			nowRow++;
@@ -453,8 +619,6 @@ void JudgingThread::compareRealNumbers(const QString &contestantOutput) {
 
 	score = fullScore;
 	result = CorrectAnswer;
-	fclose(contestantOutputFile);
-	fclose(standardOutputFile);
 }
 
 void JudgingThread::lemonSpecialJudge(const QString &fileName) {
@@ -479,14 +643,14 @@ void JudgingThread::lemonSpecialJudge(const QString &fileName) {
 		return;
 	}
 
-	auto judge = std::make_unique<QProcess>(this);
+	ProcessLauncher judge(&stopJudging);
 	QStringList arguments;
 	arguments << inputFile << fileName << outputFile << QString("%1").arg(fullScore);
 	arguments << workingDirectory + "_score";
 	arguments << workingDirectory + "_message";
-	judge->start(Settings::dataPath() + task->getSpecialJudge(), arguments);
+	judge.setProgram(specialJudge, arguments);
 
-	if (! judge->waitForStarted(-1)) {
+	if (! judge.start()) {
 		score = 0;
 		result = InvalidSpecialJudge;
 		return;
@@ -500,32 +664,21 @@ void JudgingThread::lemonSpecialJudge(const QString &fileName) {
 		messageFile.remove();
 	});
 
-	QElapsedTimer timer;
-	timer.start();
-	bool flag = false;
-
-	while (timer.elapsed() < specialJudgeTimeLimit) {
-		if (judge->waitForFinished(10)) {
-			flag = true;
-			break;
-		}
-
-		QCoreApplication::processEvents();
+	ProcessLauncher::WaitResult status = judge.waitForFinished(specialJudgeTimeLimit);
 
-		if (stopJudging) {
-			judge->kill();
-			return;
-		}
+	if (status == ProcessLauncher::Stopped) {
+		judge.kill();
+		return;
 	}
 
-	if (! flag) {
-		judge->kill();
+	if (status == ProcessLauncher::TimedOut) {
+		judge.kill();
 		score = 0;
 		result = SpecialJudgeTimeLimitExceeded;
 		return;
 	}
 
-	if (judge->exitCode() != 0) {
+	if (judge.exitCode() != 0) {
 		score = 0;
 		result = SpecialJudgeRunTimeError;
 		return;
@@ -592,13 +745,13 @@ void JudgingThread::testlibSpecialJudge(const QString &fileName) {
 		return;
 	}
 
-	auto judge = std::make_unique<QProcess>(this);
+	ProcessLauncher judge(&stopJudging);
 	QStringList arguments;
 	arguments << inputFile << fileName << outputFile;
-	judge->setStandardErrorFile(workingDirectory + "_score");
-	judge->start(Settings::dataPath() + task->getSpecialJudge(), arguments);
+	judge.setProgram(specialJudge, arguments);
+	judge.setStandardErrorFile(workingDirectory + "_score");
 
-	if (! judge->waitForStarted(-1)) {
+	if (! judge.start()) {
 		score = 0;
 		result = InvalidSpecialJudge;
 		return;
@@ -608,26 +761,15 @@ void JudgingThread::testlibSpecialJudge(const QString &fileName) {
 
 	auto removeTempFiles = qScopeGuard([&] { scoreFile.remove(); });
 
-	QElapsedTimer timer;
-	timer.start();
-	bool flag = false;
+	ProcessLauncher::WaitResult status = judge.waitForFinished(specialJudgeTimeLimit);
 
-	while (timer.elapsed() < specialJudgeTimeLimit) {
-		if (judge->waitForFinished(10)) {
-			flag = true;
-			break;
-		}
-
-		QCoreApplication::processEvents();
-
-		if (stopJudging) {
-			judge->kill();
-			return;
-		}
+	if (status == ProcessLauncher::Stopped) {
+		judge.kill();
+		return;
 	}
 
-	if (! flag) {
-		judge->kill();
+	if (status == ProcessLauncher::TimedOut) {
+		judge.kill();
 		score = 0;
 		result = SpecialJudgeTimeLimitExceeded;
 		return;
@@ -641,45 +783,169 @@ void JudgingThread::testlibSpecialJudge(const QString &fileName) {
 
 	QTextStream scoreStream(&scoreFile);
 	message = scoreStream.readAll();
+	score = testlibScore(message, fullScore);
 
-	score = 0;
-
-	if (message.startsWith("ok")) {
-		score = fullScore;
+	if (scoreStream.status() == QTextStream::ReadCorruptData) {
+		score = 0;
+		result = InvalidSpecialJudge;
+		return;
 	}
 
-	if (message.startsWith("FAIL")) {
+	scoreFile.close();
+
+	if (score < 0) {
 		score = 0;
 		result = InvalidSpecialJudge;
 		return;
 	}
 
-	QRegularExpressionMatch m = QRegularExpression(R"(^partially correct \((\d+)\))").match(message);
-	if (m.hasMatch()) {
-		int val = m.captured(1).toInt();
-		score = val * fullScore / 100;
+	if (score == 0)
+		result = WrongAnswer;
+
+	if (0 < score && score < fullScore)
+		result = PartlyCorrect;
+
+	if (score >= fullScore)
+		result = CorrectAnswer;
+}
+
+void JudgingThread::checkerPlugin(const QString &fileName) {
+	if (! QFileInfo::exists(inputFile)) {
+		score = 0;
+		result = FileError;
+		message = tr("Cannot find standard input file");
+		return;
 	}
 
-	m = QRegularExpression(R"(^points ([0-9]*\.[0-9]+|[0-9]+))").match(message);
-	if (m.hasMatch()) {
-		double val = m.captured(1).toDouble();
-		score = val * fullScore;
+	if (! QFileInfo::exists(fileName)) {
+		score = 0;
+		result = FileError;
+		message = tr(R"(Cannot find contestant's output file)");
+		return;
 	}
 
-	if (scoreStream.status() == QTextStream::ReadCorruptData) {
+	if (! QFileInfo::exists(outputFile)) {
 		score = 0;
+		result = FileError;
+		message = tr("Cannot find standard output file");
+		return;
+	}
+
+	// Loaded once for the judge session, or just for this test case
+	std::shared_ptr<CheckerPlugin> plugin;
+	if (checkerPlugins)
+		plugin = checkerPlugins->get(specialJudge);
+	else
+		plugin = std::make_shared<CheckerPlugin>(specialJudge);
+
+	auto checked =
+	    plugin->check(inputFile, fileName, outputFile, fullScore, specialJudgeTimeLimit, &stopJudging);
+	score = 0;
+
+	switch (checked.status) {
+		case CheckerPlugin::Stopped:
+			return;
+
+		case CheckerPlugin::Unusable:
+			result = InvalidSpecialJudge;
+			message = checked.message;
+			return;
+
+		case CheckerPlugin::Failed:
+			result = SpecialJudgeRunTimeError;
+			message = checked.message;
+			return;
+
+		case CheckerPlugin::TimedOut:
+			result = SpecialJudgeTimeLimitExceeded;
+			return;
+
+		case CheckerPlugin::Checked:
+			break;
+	}
+
+	if (checked.score < 0) {
 		result = InvalidSpecialJudge;
 		return;
 	}
 
-	scoreFile.close();
+	score = checked.score;
+	message = checked.message;
 
-	if (score < 0) {
+	if (score == 0)
+		result = WrongAnswer;
+
+	if (0 < score && score < fullScore)
+		result = PartlyCorrect;
+
+	if (score >= fullScore)
+		result = CorrectAnswer;
+}
+
+void JudgingThread::batchSpecialJudge(const QString &fileName) {
+	if (! QFileInfo::exists(inputFile)) {
+		score = 0;
+		result = FileError;
+		message = tr("Cannot find standard input file");
+		return;
+	}
+
+	if (! QFileInfo::exists(fileName)) {
+		score = 0;
+		result = FileError;
+		message = tr(R"(Cannot find contestant's output file)");
+		return;
+	}
+
+	if (! QFileInfo::exists(outputFile)) {
 		score = 0;
+		result = FileError;
+		message = tr("Cannot find standard output file");
+		return;
+	}
+
+	// Started once for the contestant's task, or just for this test case
+	std::unique_ptr<BatchChecker> ownChecker;
+	BatchChecker *checker = batchChecker;
+
+	if (! checker) {
+		ownChecker = std::make_unique<BatchChecker>(specialJudge);
+		checker = ownChecker.get();
+	}
+
+	auto checked =
+	    checker->check(inputFile, fileName, outputFile, fullScore, specialJudgeTimeLimit, &stopJudging);
+	score = 0;
+
+	switch (checked.status) {
+		case BatchChecker::Stopped:
+			return;
+
+		case BatchChecker::Unusable:
+			result = InvalidSpecialJudge;
+			message = checked.message;
+			return;
+
+		case BatchChecker::Failed:
+			result = SpecialJudgeRunTimeError;
+			return;
+
+		case BatchChecker::TimedOut:
+			result = SpecialJudgeTimeLimitExceeded;
+			return;
+
+		case BatchChecker::Checked:
+			break;
+	}
+
+	if (checked.score < 0) {
 		result = InvalidSpecialJudge;
 		return;
 	}
 
+	score = checked.score;
+	message = checked.message;
+
 	if (score == 0)
 		result = WrongAnswer;
 
@@ -690,22 +956,59 @@ void JudgingThread::testlibSpecialJudge(const QString &fileName) {
 		result = CorrectAnswer;
 }
 
-void JudgingThread::judgeOutput() {
-	QString fileName;
+// What the verdict on `output` depends on, empty if that cannot be told
+auto JudgingThread::verdictKey(const OutputReader &output) -> QByteArray {
+	if (! output.valid())
+		return {};
 
-	if (task->getStandardOutputCheck()) {
-		fileName = workingDirectory + "_tmpout";
-	} else {
-		fileName = workingDirectory + task->getOutputFileName();
+	QByteArray checker;
+
+	if (task->getComparisonMode() == Task::LemonSpecialJudgeMode ||
+	    task->getComparisonMode() == Task::TestlibSpecialJudgeMode ||
+	    task->getComparisonMode() == Task::CheckerPluginMode ||
+	    task->getComparisonMode() == Task::BatchSpecialJudgeMode) {
+		checker = verdictCache->fileHash(specialJudge);
+
+		if (checker.isEmpty())
+			return {};
+	}
+
+	QStringList fields;
+	fields << QString::number(reinterpret_cast<quintptr>(task)) << inputFile << outputFile
+	       << QString::number(fullScore) << QString::number(int(task->getComparisonMode()))
+	       << task->getDiffArguments() << diffPath << QString::number(task->getRealPrecision());
+
+	return fields.join(QChar('\0')).toUtf8() + '\0' + checker + verdictCache->hash(output.contents());
+}
+
+void JudgingThread::judgeOutput(const QString &fileName) {
+	// Mapped once, for the key and for the comparators reading it. The key is
+	// looked up before comparing, so its hash cannot be taken along the way.
+	OutputReader output(fileName);
+	const QByteArray key = task->getCacheVerdicts() && verdictCache ? verdictKey(output) : QByteArray();
+	VerdictCache::Verdict verdict;
+
+	if (! key.isEmpty() && verdictCache->find(key, verdict)) {
+		score = verdict.score;
+		result = verdict.result;
+
+		if (! verdict.keepMessage)
+			message = verdict.message;
+
+		return;
 	}
 
+	// What the program wrote to stderr, unless the comparison has something
+	// to say
+	const QString runMessage = message;
+
 	switch (task->getComparisonMode()) {
 		case Task::LineByLineMode:
-			compareLineByLine(fileName);
+			compareLineByLine(output);
 			break;
 
 		case Task::IgnoreSpacesMode:
-			compareIgnoreSpaces(fileName);
+			compareIgnoreSpaces(output);
 			break;
 
 		case Task::ExternalToolMode:
@@ -713,7 +1016,7 @@ void JudgingThread::judgeOutput() {
 			break;
 
 		case Task::RealNumberMode:
-			compareRealNumbers(fileName);
+			compareRealNumbers(output);
 			break;
 
 		case Task::LemonSpecialJudgeMode:
@@ -723,7 +1026,25 @@ void JudgingThread::judgeOutput() {
 		case Task::TestlibSpecialJudgeMode:
 			testlibSpecialJudge(fileName);
 			break;
+
+		case Task::BinaryMode:
+			compareBinary(fileName);
+			break;
+
+		case Task::CheckerPluginMode:
+			checkerPlugin(fileName);
+			break;
+
+		case Task::BatchSpecialJudgeMode:
+			batchSpecialJudge(fileName);
+			break;
 	}
+
+	// Only what the output earned, not a failure to judge it
+	if (! key.isEmpty() && ! stopJudging &&
+	    (result == CorrectAnswer || result == WrongAnswer || result == PartlyCorrect ||
+	     result == PresentationError || result == OutputLimitExceeded))
+		verdictCache->insert(key, {score, result, message, message == runMessage});
 }
 
 void JudgingThread::judgeTraditionalTask() {
@@ -734,7 +1055,8 @@ void JudgingThread::judgeTraditionalTask() {
 		return;
 	}
 
-	if (! task->getStandardInputCheck()) {
+	// Otherwise the runner mounts the input file in place
+	if (! task->getStandardInputCheck() && ! ProcessRunner::bindsReadOnlyFiles()) {
 		if (! QFile::copy(inputFile, workingDirectory + task->getInputFileName())) {
 			score = 0;
 			result = FileError;
@@ -748,11 +1070,10 @@ void JudgingThread::judgeTraditionalTask() {
 			QFile::remove(workingDirectory + task->getInputFileName());
 		}
 
-		if (! task->getStandardOutputCheck()) {
-			QFile::remove(workingDirectory + task->getOutputFileName());
-		} else {
-			QFile::remove(workingDirectory + "_tmpout");
-		}
+		// Kept for checkOutput() if it has to be judged
+		if (outputToCheck.isEmpty())
+			removeOutput();
+
 		QFile::remove(workingDirectory + "_tmperr");
 	});
 
@@ -772,9 +1093,16 @@ void JudgingThread::judgeTraditionalTask() {
 	cfg.inputFileName = task->getInputFileName();
 	cfg.outputFileName = task->getOutputFileName();
 	cfg.interpreterAsWatcher = interpreterAsWatcher;
+	cfg.runInShell = runInShell;
+	cfg.readOnlyFiles = readOnlyFiles;
+
+	auto processRunner = ProcessRunner::create(cfg, stopProgram);
+	ProcessRunnerResult runResult;
+	bool outputChecked = runCheckingOutput(*processRunner, runResult);
+
+	if (! outputChecked)
+		runResult = processRunner->run();
 
-	auto processRunner = ProcessRunner::create(cfg, stopJudging);
-	auto runResult = processRunner->run();
 	result = runResult.result;
 	score = runResult.score;
 	timeUsed = runResult.timeUsed;
@@ -797,44 +1125,349 @@ void JudgingThread::judgeTraditionalTask() {
 	if (result != CorrectAnswer)
 		return;
 
-	judgeOutput();
+	if (outputChecked) {
+		score = fullScore;
+		return;
+	}
+
+	if (task->getStandardOutputCheck()) {
+		outputToCheck = workingDirectory + "_tmpout";
+	} else {
+		outputToCheck = workingDirectory + task->getOutputFileName();
+	}
 }
 
-void JudgingThread::judgeAnswersOnlyTask() {
-	switch (task->getComparisonMode()) {
-		case Task::LineByLineMode:
-			compareLineByLine(answerFile);
-			break;
+void JudgingThread::removeOutput() {
+	if (! task->getStandardOutputCheck()) {
+		QFile::remove(workingDirectory + task->getOutputFileName());
+	} else {
+		QFile::remove(workingDirectory + "_tmpout");
+	}
+}
 
-		case Task::IgnoreSpacesMode:
-			compareIgnoreSpaces(answerFile);
-			break;
+// Compare the standard output with the answer while the program writes it,
+// through a pipe instead of _tmpout, and stop the program at the first
+// difference. A wrong output stopping the program takes the place of what the
+// run gave, the program may not have got to crash or run out of time. Once the
+// program ended on its own, what the run gave comes first as it would without
+// this, a crash after a right prefix of the answer is still a crash. False
+// without running the program if the task does not want this or it is not
+// possible.
+auto JudgingThread::runCheckingOutput(ProcessRunner &processRunner, ProcessRunnerResult &runResult) -> bool {
+#ifdef Q_OS_WIN32
+	return false;
+#else
+	const auto mode = task->getComparisonMode();
+
+	if (! task->getCheckWhileRunning() || ! task->getStandardOutputCheck() ||
+	    (mode != Task::LineByLineMode && mode != Task::IgnoreSpacesMode && mode != Task::RealNumberMode))
+		return false;
+
+	StopSignal finished;
+	OutputReader contestantReader(workingDirectory + "_tmpout", &finished);
+
+	if (! contestantReader.valid())
+		return false;
+
+	// Whether the program was stopped for what it wrote before it ended. The
+	// pipe only ends once `finished` is raised, so that output was not cut short.
+	bool rejected = false;
+
+	// Sets score, result and message, which are left alone here until it ends
+	std::thread checker([&] {
+		if (mode == Task::LineByLineMode)
+			compareLineByLine(contestantReader);
+		else if (mode == Task::IgnoreSpacesMode)
+			compareIgnoreSpaces(contestantReader);
+		else
+			compareRealNumbers(contestantReader);
 
-		case Task::ExternalToolMode:
-			compareWithDiff(answerFile);
-			break;
+		// Never lowered again, a wrong output ends this test case anyway
+		if (result != CorrectAnswer && ! finished.isRaised()) {
+			rejected = true;
+			stopProgram.raise();
+		}
+	});
 
-		case Task::RealNumberMode:
-			compareRealNumbers(answerFile);
-			break;
+	runResult = processRunner.run();
+	finished.raise();
+	checker.join();
 
-		case Task::LemonSpecialJudgeMode:
-			lemonSpecialJudge(answerFile);
-			break;
+	if (result != CorrectAnswer && ! stopJudging && (rejected || runResult.result == CorrectAnswer)) {
+		runResult.result = result;
+		runResult.score = score;
+		runResult.message = message;
+	}
 
-		case Task::TestlibSpecialJudgeMode:
-			testlibSpecialJudge(answerFile);
-			break;
+	return true;
+#endif
+}
+
+// Run the program against the interactor of the task, each in a process of
+// its own: what the program writes is the standard input of the interactor
+// and the other way round. The pipes are FIFOs, for each side to open by
+// name inside a sandbox of its own. The interactor follows testlib, it is
+// given the input file, a file of its own to write and the standard output,
+// and tells its verdict on stderr.
+void JudgingThread::judgeInteractionTask() {
+#ifndef Q_OS_LINUX
+	score = 0;
+	result = InteractorError;
+	message = tr("Interactors running on their own are only supported on Linux");
+#else
+	if (! QFileInfo::exists(inputFile)) {
+		score = 0;
+		result = FileError;
+		message = tr("Cannot find standard input file");
+		return;
 	}
+
+	// Next to the working directory, out of the program's reach
+	const QString interactorDirectory = QDir::cleanPath(workingDirectory) + "_interactor/";
+	const QByteArray fromProgram = QFile::encodeName(workingDirectory + "_tmpout");
+	const QByteArray toProgram = QFile::encodeName(interactorDirectory + "_tmpout");
+	int fromProgramRead = -1;
+	int fromProgramWrite = -1;
+	int toProgramRead = -1;
+	int toProgramWrite = -1;
+
+	auto closeDescriptor = [](int &descriptor) {
+		if (descriptor != -1)
+			::close(descriptor);
+
+		descriptor = -1;
+	};
+
+	auto cleanupTempFiles = qScopeGuard([&] {
+		for (int *descriptor : {&fromProgramRead, &fromProgramWrite, &toProgramRead, &toProgramWrite})
+			closeDescriptor(*descriptor);
+
+		QFile::remove(workingDirectory + "_tmpout");
+		QFile::remove(workingDirectory + "_tmperr");
+		QDir(interactorDirectory).removeRecursively();
+	});
+
+	if (QDir().mkpath(interactorDirectory) && ::mkfifo(fromProgram.constData(), 0666) == 0 &&
+	    ::mkfifo(toProgram.constData(), 0666) == 0) {
+		// The read ends are held here to the end, so that neither side waits
+		// to open its write end or dies writing once the other is over, as
+		// far as the pipe holds it. The write ends until the side writing is
+		// over, the watcher opens the read end without waiting for a writer.
+		fromProgramRead = ::open(fromProgram.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		fromProgramWrite = ::open(fromProgram.constData(), O_WRONLY | O_CLOEXEC);
+		toProgramRead = ::open(toProgram.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		toProgramWrite = ::open(toProgram.constData(), O_WRONLY | O_CLOEXEC);
+	}
+
+	if (fromProgramRead == -1 || fromProgramWrite == -1 || toProgramRead == -1 || toProgramWrite == -1) {
+		score = 0;
+		result = InteractorError;
+		message = tr("Cannot create the pipes to the interactor");
+		return;
+	}
+
+	// Fewer round trips through the scheduler when either side writes a lot,
+	// where the system allows it
+	constexpr int pipeSize = 1 << 20;
+	::fcntl(fromProgramWrite, F_SETPIPE_SZ, pipeSize);
+	::fcntl(toProgramWrite, F_SETPIPE_SZ, pipeSize);
+
+	ProcessRunnerConfig cfg;
+	cfg.executableFile = executableFile;
+	cfg.arguments = arguments;
+	cfg.workingDirectory = workingDirectory;
+	cfg.inputFile = QFile::decodeName(toProgram);
+	cfg.environment = environment;
+	cfg.timeLimit = timeLimit;
+	cfg.rawTimeLimit = rawTimeLimit;
+	cfg.memoryLimit = memoryLimit;
+	cfg.rawMemoryLimit = rawMemoryLimit;
+	cfg.extraTimeRatio = extraTimeRatio;
+	// The pipes take the place of the files, whatever the task says
+	cfg.standardInputCheck = true;
+	cfg.standardOutputCheck = true;
+	cfg.interpreterAsWatcher = interpreterAsWatcher;
+	cfg.runInShell = runInShell;
+	cfg.readOnlyFiles = readOnlyFiles;
+	// Each side may be waiting for the other, which no CPU time limit sees
+	cfg.wallTimeLimit = static_cast<int>(std::ceil(timeLimit * (1 + extraTimeRatio))) * 2 + 1000;
+
+	// The watcher splits the arguments into words as a shell would
+	auto quoted = [](QString argument) { return "'" + argument.replace("'", R"('\'')") + "'"; };
+	const QString interactorFile = QFileInfo(interactor).absoluteFilePath();
+	const QString inputPath = QFileInfo(inputFile).absoluteFilePath();
+	const QString answerPath = QFileInfo(outputFile).absoluteFilePath();
+
+	// The interactor has a sandbox of its own, with the time limit of a special
+	// judge on its CPU time and the memory limit of the test case
+	ProcessRunnerConfig judgeCfg;
+	judgeCfg.executableFile = interactorFile;
+	judgeCfg.arguments =
+	    QStringList{quoted(inputPath), quoted(interactorDirectory + "_tout"), quoted(answerPath)}.join(' ');
+	judgeCfg.workingDirectory = interactorDirectory;
+	judgeCfg.inputFile = QFile::decodeName(fromProgram);
+	judgeCfg.timeLimit = specialJudgeTimeLimit;
+	judgeCfg.rawTimeLimit = specialJudgeTimeLimit;
+	judgeCfg.memoryLimit = memoryLimit;
+	judgeCfg.rawMemoryLimit = rawMemoryLimit;
+	judgeCfg.extraTimeRatio = extraTimeRatio;
+	judgeCfg.standardInputCheck = true;
+	judgeCfg.standardOutputCheck = true;
+	judgeCfg.readOnlyFiles = QStringList{interactorFile, inputPath, answerPath};
+	// As long as the program may run, and the time limit of a special judge
+	// once it is over
+	judgeCfg.wallTimeLimit = cfg.wallTimeLimit + specialJudgeTimeLimit;
+
+	StopSignal stopInteractor;
+	auto programRunner = ProcessRunner::create(cfg, stopProgram);
+	auto interactorRunner = ProcessRunner::create(judgeCfg, stopInteractor);
+	ProcessRunnerResult runResult;
+	ProcessRunnerResult judgeResult;
+	StopSignal programEnded;
+	StopSignal interactorEnded;
+
+	// Each on a thread of its own, which has no sandbox zygote: it would move
+	// the working directory, and the FIFO in it, away from the other side
+	std::thread program([&] {
+		runResult = programRunner->run();
+		programEnded.raise();
+	});
+
+	std::thread judge([&] {
+		judgeResult = interactorRunner->run();
+		interactorEnded.raise();
+	});
+
+	StopSignal::waitForAny({&programEnded, &interactorEnded, &stopJudging});
+
+	const bool interactorFirst = interactorEnded.isRaised() && ! programEnded.isRaised();
+	bool interactorTimedOut = false;
+	QString verdict;
+
+	auto readVerdict = [&] {
+		QFile scoreFile(interactorDirectory + "_tmperr");
+
+		if (scoreFile.open(QFile::ReadOnly))
+			verdict = QString::fromUtf8(scoreFile.readAll());
+	};
+
+	if (interactorFirst) {
+		// The end of file for the program
+		closeDescriptor(toProgramWrite);
+		readVerdict();
+
+		// The program may be waiting for what never comes
+		if (! verdict.startsWith("ok"))
+			stopProgram.raise();
+	}
+
+	program.join();
+
+	// The end of file for the interactor
+	closeDescriptor(fromProgramWrite);
+
+	// Then the time limit of a special judge
+	if (! interactorEnded.isRaised() && ! stopJudging)
+		interactorTimedOut =
+		    ! StopSignal::waitForAny({&interactorEnded, &stopJudging}, QDeadlineTimer(specialJudgeTimeLimit));
+
+	if (interactorTimedOut || stopJudging)
+		stopInteractor.raise();
+
+	judge.join();
+
+	if (! interactorFirst)
+		readVerdict();
+
+	if (stopJudging)
+		return;
+
+	timeUsed = runResult.timeUsed;
+	memoryUsed = runResult.memoryUsed;
+
+	// Its own failures are the judge's
+	if (interactorTimedOut || judgeResult.result == TimeLimitExceeded) {
+		score = 0;
+		result = InteractorError;
+		message = tr("Interactor time limit exceeded");
+		return;
+	}
+
+	if (judgeResult.result == MemoryLimitExceeded) {
+		score = 0;
+		result = InteractorError;
+		message = tr("Interactor memory limit exceeded");
+		return;
+	}
+
+	if (judgeResult.result == CannotStartProgram) {
+		score = 0;
+		result = InteractorError;
+		message = tr("Cannot start the interactor");
+		return;
+	}
+
+	const int interactorScore = testlibScore(verdict, fullScore);
+
+	if (interactorScore < 0) {
+		score = 0;
+		result = InteractorError;
+		message = verdict;
+		return;
+	}
+
+	// What went wrong with the program comes first, unless the interactor
+	// rejected it and had it stopped
+	if (! interactorFirst || verdict.startsWith("ok")) {
+		result = runResult.result;
+		score = runResult.score;
+		message = runResult.message;
+
+		if (timeUsed > timeLimit) {
+			if (score > 0 && (timeUsed <= timeLimit * (1 + extraTimeRatio) ||
+			                  timeUsed <= timeLimit + 1000 * extraTimeRatio)) {
+				needRejudge = true;
+			}
+			score = 0;
+			result = TimeLimitExceeded;
+			message = "";
+		}
+
+		if (result != CorrectAnswer)
+			return;
+	}
+
+	score = interactorScore;
+	message = verdict;
+
+	if (score == 0)
+		result = WrongAnswer;
+
+	if (0 < score && score < fullScore)
+		result = PartlyCorrect;
+
+	if (score >= fullScore)
+		result = CorrectAnswer;
+#endif
 }
 
-void JudgingThread::run() {
+void JudgingThread::judgeAnswersOnlyTask() { judgeOutput(answerFile); }
+
+void JudgingThread::runProgram() {
 	++judgedTimes;
 	needRejudge = false;
+	outputToCheck.clear();
 
 	switch (task->getTaskType()) {
-		case Task::Interaction: // treat interaction task as traditional task
+		case Task::Interaction:
+			if (task->getRunInteractor()) {
+				judgeInteractionTask();
+				break;
+			}
+
+			// Otherwise the interactor is compiled in, as in a traditional task
 			[[fallthrough]];
+
 		case Task::Traditional:
 			[[fallthrough]];
 		case Task::Communication:
@@ -847,4 +1480,20 @@ void JudgingThread::run() {
 			judgeAnswersOnlyTask();
 			break;
 	}
+}
+
+void JudgingThread::checkOutput() {
+	if (outputToCheck.isEmpty())
+		return;
+
+	if (! stopJudging)
+		judgeOutput(outputToCheck);
+
+	removeOutput();
+	outputToCheck.clear();
+}
+
+void JudgingThread::run() {
+	runProgram();
+	checkOutput();
 }
\ No newline at end of file
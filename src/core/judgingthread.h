@@ -12,13 +12,19 @@
 
 #include "base/LemonType.hpp"
 #include "processrunner.h"
+#include <QObject>
 #include <QProcessEnvironment>
-#include <QThread>
-#include <atomic>
 
+class AnswerCache;
+class BatchChecker;
+class CheckerPlugins;
+class OutputReader;
 class Task;
+class VerdictCache;
 
-class JudgingThread : public QThread {
+// Judges a single test case. Despite the name it no longer owns a thread:
+// TaskJudger calls run() on a JudgingPool worker.
+class JudgingThread : public QObject {
 	Q_OBJECT
   public:
 	explicit JudgingThread(QObject *parent = nullptr);
@@ -26,7 +32,11 @@ class JudgingThread : public QThread {
 	void setExtraTimeRatio(double);
 	void setEnvironment(const QProcessEnvironment &);
 	void setWorkingDirectory(const QString &);
+	// The program, plugin or library given by the task, after it was built
+	void setSpecialJudge(const QString &);
 	void setSpecialJudgeTimeLimit(int);
+	// The interactor program of an interaction task that runs it on its own
+	void setInteractor(const QString &);
 	void setExecutableFile(const QString &);
 	void setArguments(const QString &);
 	void setAnswerFile(const QString &);
@@ -40,6 +50,12 @@ class JudgingThread : public QThread {
 	void setMemoryLimit(int);
 	void setRawMemoryLimit(int);
 	void setInterpreterAsWatcher(bool);
+	void setRunInShell(bool);
+	void setReadOnlyFiles(const QStringList &);
+	void setAnswerCache(AnswerCache *);
+	void setVerdictCache(VerdictCache *);
+	void setCheckerPlugins(CheckerPlugins *);
+	void setBatchChecker(BatchChecker *);
 	int getTimeUsed() const;
 	qint64 getMemoryUsed() const;
 	int getScore() const;
@@ -48,6 +64,12 @@ class JudgingThread : public QThread {
 	ResultState getResult() const;
 	const QString &getMessage() const;
 	bool getNeedRejudge() const;
+	// The two stages of run(), which may be called on different threads:
+	// runProgram() leaves the output in the working directory when it has to
+	// be judged by checkOutput()
+	void runProgram();
+	bool hasOutputToCheck() const;
+	void checkOutput();
 	void run();
 
   private:
@@ -64,7 +86,10 @@ class JudgingThread : public QThread {
 	QString inputFile;
 	QString outputFile;
 	QString diffPath;
+	QString outputToCheck;
 	Task *task{};
+	QString specialJudge;
+	QString interactor;
 	int specialJudgeTimeLimit{};
 	int fullScore{};
 	int timeLimit{};
@@ -77,19 +102,35 @@ class JudgingThread : public QThread {
 	int judgedTimes;
 	ResultState result;
 	QString message;
-	std::atomic<bool> stopJudging{false};
+	StopSignal stopJudging;
+	// Raised with stopJudging, or when the output checked while the program
+	// runs is wrong
+	StopSignal stopProgram;
 	bool interpreterAsWatcher{};
-	void compareLineByLine(const QString &);
-	void compareIgnoreSpaces(const QString &);
+	bool runInShell{};
+	QStringList readOnlyFiles;
+	AnswerCache *answerCache{};
+	VerdictCache *verdictCache{};
+	CheckerPlugins *checkerPlugins{};
+	BatchChecker *batchChecker{};
+	OutputReader readStandardOutput();
+	void compareLineByLine(OutputReader &);
+	void compareIgnoreSpaces(OutputReader &);
+	void compareBinary(const QString &);
 	void compareWithDiff(const QString &);
-	void compareRealNumbers(const QString &);
+	void compareRealNumbers(OutputReader &);
 	void lemonSpecialJudge(const QString &);
 	void testlibSpecialJudge(const QString &);
+	void checkerPlugin(const QString &);
+	void batchSpecialJudge(const QString &);
 
-	void judgeOutput();
+	QByteArray verdictKey(const OutputReader &);
+	void judgeOutput(const QString &);
+	bool runCheckingOutput(ProcessRunner &, ProcessRunnerResult &);
+	void removeOutput();
 	void judgeTraditionalTask();
 	void judgeAnswersOnlyTask();
-	// void judgeInteractionTask();
+	void judgeInteractionTask();
 
   public slots:
 	void stopJudgingSlot();
@@ -0,0 +1,555 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "outputreader.h"
+
+#include <QtAlgorithms>
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#ifndef Q_OS_WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define LEMON_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace {
+	// What std::isspace() accepts in the "C" locale
+	auto isSpace(char c) -> bool { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+	auto isLineBreak(char c) -> bool { return c == '\n' || c == '\r'; }
+
+	auto isDigit(char c) -> bool { return c >= '0' && c <= '9'; }
+
+	auto isHexDigit(char c) -> bool {
+		return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+	}
+
+	auto toLower(char c) -> char { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+	// Whether `word` follows at p, case-insensitively, consuming what matches
+	auto match(const char *&p, const char *end, const char *word) -> bool {
+		for (; *word != '\0'; word++, p++)
+			if (p == end || toLower(*p) != *word)
+				return false;
+
+		return true;
+	}
+
+	// Decimal numbers of up to 19 significant digits and a small exponent, as
+	// most outputs have them: both the digits and the power of ten are exact
+	// long doubles, so the one rounding of the product gives exactly what
+	// strtold() would. False for anything else.
+	auto parseShortDecimal(const char *p, const char *end, long double &value) -> bool {
+		constexpr int maxExponent = std::numeric_limits<long double>::digits >= 64 ? 27 : 22;
+		static const auto powers = [] {
+			std::array<long double, maxExponent + 1> result{};
+			result[0] = 1;
+			for (int i = 1; i <= maxExponent; i++)
+				result[i] = result[i - 1] * 10;
+			return result;
+		}();
+
+		quint64 mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool afterDot = false;
+
+		for (; p != end && (isDigit(*p) || (*p == '.' && ! afterDot)); p++) {
+			if (*p == '.') {
+				afterDot = true;
+				continue;
+			}
+			if (mantissa == 0 && *p == '0') {
+				exponent -= afterDot;
+				continue;
+			}
+			if (digits == 19)
+				return false;
+			mantissa = mantissa * 10 + (*p - '0');
+			digits++;
+			exponent -= afterDot;
+		}
+
+		// An exponent without digits is not part of the number
+		if (p != end && toLower(*p) == 'e') {
+			const char *q = p + 1;
+			bool negative = q != end && *q == '-';
+
+			if (q != end && (*q == '-' || *q == '+'))
+				q++;
+
+			int power = 0;
+
+			for (; q != end && isDigit(*q); q++) {
+				if (power > 10000)
+					return false;
+				power = power * 10 + (*q - '0');
+			}
+
+			exponent += negative ? -power : power;
+		}
+
+		if (std::numeric_limits<long double>::digits < 64 &&
+		    (mantissa >> qMin(std::numeric_limits<long double>::digits, 63)) != 0)
+			return false;
+
+		if (mantissa == 0) {
+			value = 0;
+			return true;
+		}
+
+		if (exponent > maxExponent || exponent < -maxExponent)
+			return false;
+
+		auto number = static_cast<long double>(mantissa);
+		value = exponent < 0 ? number / powers[-exponent] : number * powers[exponent];
+		return true;
+	}
+
+	// The value of [first, last), which nextReal() has found to hold a number
+	// in the syntax of strtold()
+	auto convertReal(const char *first, const char *last, bool hex) -> long double {
+		bool negative = *first == '-';
+
+		if (*first == '-' || *first == '+')
+			first++;
+
+		long double value = 0;
+
+		if (! hex && parseShortDecimal(first, last, value))
+			return negative ? -value : value;
+
+#if defined(__cpp_lib_to_chars)
+		if (! hex) {
+			auto [end, error] = std::from_chars(first, last, value);
+
+			if (error == std::errc() && end != first)
+				return negative ? -value : value;
+		}
+#endif
+
+		// Hexadecimal, or out of range where strtold() knows what to return
+		std::string text(first, last);
+		value = strtold(text.c_str(), nullptr);
+		return negative ? -value : value;
+	}
+
+	// Number of line terminators (\n, \r, or \r\n) in p[0, n), for `n` not
+	// splitting a \r\n
+	auto countLineBreaks(const char *p, std::size_t n) -> qint64 {
+		qint64 count = 0;
+		std::size_t i = 0;
+#ifdef LEMON_SSE2
+		const __m128i lf = _mm_set1_epi8('\n');
+		const __m128i cr = _mm_set1_epi8('\r');
+
+		for (; i + 16 <= n; i += 16) {
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+			auto lfMask = static_cast<quint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, lf)));
+			auto crMask = static_cast<quint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, cr)));
+
+			// A \r right before a \n is not a terminator of its own
+			if (i + 16 < n && p[i + 16] == '\n')
+				lfMask |= 1U << 16;
+
+			count += qPopulationCount(lfMask & 0xFFFF) + qPopulationCount(crMask & ~(lfMask >> 1));
+		}
+#endif
+		for (; i < n; i++)
+			count += p[i] == '\n' || (p[i] == '\r' && (i + 1 == n || p[i + 1] != '\n'));
+
+		return count;
+	}
+
+	// Where nextUntilNewLine() is sure to end a chunk in both files when they
+	// agree on p[0, q), starting between two chunks at p: on the terminator
+	// before the last line, or on a multiple of 32 chars into that line
+	auto lineBoundary(const char *p, std::size_t q) -> std::size_t {
+		std::size_t j = q;
+
+		while (j > 0 && ! isLineBreak(p[j - 1]))
+			j--;
+
+		if (j == 0)
+			return q / 32 * 32;
+
+		std::size_t terminator = j - 1;
+
+		if (p[terminator] == '\n' && terminator > 0 && p[terminator - 1] == '\r')
+			terminator--;
+		// A \r may yet be followed by a \n in one of the files only
+		else if (p[terminator] == '\r' && j == q)
+			return terminator;
+
+		std::size_t chunks = (q - j) / 32;
+		return chunks > 0 ? j + chunks * 32 : terminator;
+	}
+
+	// The same for nextUntilSpace(): at the start of the spaces before the
+	// last token, or on a multiple of 32 chars into that token
+	auto tokenBoundary(const char *p, std::size_t q) -> std::size_t {
+		std::size_t j = q;
+
+		while (j > 0 && ! isSpace(p[j - 1]))
+			j--;
+
+		if (j == 0)
+			return q / 32 * 32;
+
+		if (q - j >= 32)
+			return j + (q - j) / 32 * 32;
+
+		for (j--; j > 0 && isSpace(p[j - 1]);)
+			j--;
+
+		return j;
+	}
+} // namespace
+
+OutputReader::OutputReader(const QString &fileName) : file(fileName) {
+	isValid = file.open(QFile::ReadOnly);
+
+	if (! isValid || file.size() == 0)
+		return;
+
+	if (uchar *data = file.map(0, file.size())) {
+		begin = reinterpret_cast<const char *>(data);
+		end = begin + file.size();
+	} else {
+		buffer = file.readAll();
+		begin = buffer.constData();
+		end = begin + buffer.size();
+	}
+
+	pos = kept = begin;
+}
+
+OutputReader::OutputReader(const QByteArray &contents) : buffer(contents) {
+	isValid = true;
+	begin = buffer.constData();
+	end = begin + buffer.size();
+	pos = kept = begin;
+}
+
+#ifndef Q_OS_WIN32
+
+OutputReader::OutputReader(const QString &fileName, const StopSignal *finished) : finished(finished) {
+	const QByteArray path = QFile::encodeName(fileName);
+	QFile::remove(fileName);
+
+	if (::mkfifo(path.constData(), 0666) != 0)
+		return;
+
+	// Holding a write end too, reading never meets the end of the pipe before
+	// the program opens it, only no data
+	descriptor = ::open(path.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+	if (descriptor != -1)
+		writeDescriptor = ::open(path.constData(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+
+	if (writeDescriptor == -1) {
+		QFile::remove(fileName);
+		return;
+	}
+
+#ifdef F_SETPIPE_SZ
+	// Fewer switches between the program and the comparator
+	::fcntl(descriptor, F_SETPIPE_SZ, 1 << 20);
+#endif
+
+	isValid = true;
+	buffer.resize(1 << 16);
+	begin = end = pos = kept = buffer.constData();
+}
+
+#endif
+
+OutputReader::~OutputReader() {
+#ifndef Q_OS_WIN32
+	if (descriptor != -1)
+		::close(descriptor);
+	if (writeDescriptor != -1)
+		::close(writeDescriptor);
+#endif
+}
+
+auto OutputReader::fill() -> bool {
+#ifndef Q_OS_WIN32
+	if (descriptor == -1 || isDrained)
+		return false;
+
+	// Move what is kept to the front, and make room if it takes up the buffer
+	auto keptSize = end - kept;
+	auto offset = pos - kept;
+	memmove(buffer.data(), kept, keptSize);
+
+	if (keptSize > buffer.size() / 2)
+		buffer.resize(buffer.size() * 2);
+
+	begin = kept = buffer.constData();
+	pos = begin + offset;
+	end = begin + keptSize;
+
+	while (true) {
+		// All the program wrote is in the pipe once it finished
+		bool last = finished->isRaised();
+		ssize_t length = ::read(descriptor, buffer.data() + keptSize, buffer.size() - keptSize);
+
+		if (length > 0) {
+			end += length;
+			return true;
+		}
+
+		if (length < 0 && errno == EINTR)
+			continue;
+
+		if (length == 0 || errno != EAGAIN || last) {
+			isDrained = true;
+			return false;
+		}
+
+		// Without an eventfd the end has to be polled for
+		pollfd fds[2] = {{descriptor, POLLIN, 0}, {finished->getDescriptor(), POLLIN, 0}};
+		::poll(fds, 2, fds[1].fd == -1 ? 10 : -1);
+	}
+#else
+	return false;
+#endif
+}
+
+auto OutputReader::peekChar() -> char {
+	if (isEof) {
+		return '\0';
+	}
+	if (pos == end && ! fill()) {
+		isEof = true;
+		return '\0';
+	}
+	return *pos;
+}
+
+// Consume one line terminator (\n, \r, or \r\n) if the cursor sits on one,
+// and bump lineNumber. Idempotent when not on a terminator -- safe to call
+// before each token read.
+void OutputReader::tryNextLine() {
+	char c = peekChar();
+	if (c != '\r' && c != '\n')
+		return;
+	if (c == '\r')
+		pos++;
+	c = peekChar();
+	if (c == '\n')
+		pos++;
+	lineNumber++;
+}
+
+// Read up to 32 chars from the current position, stopping at any line
+// terminator or EOF. Does NOT consume the terminator -- the next call to
+// tryNextLine() (invoked at the top here) will. Returning a chunk shorter
+// than 32 chars is the signal that the caller has reached end-of-line/EOF;
+// otherwise the caller must call again to read the rest of a long line.
+auto OutputReader::nextUntilNewLine() -> std::string_view {
+	tryNextLine();
+	kept = pos;
+	for (int i = 0; i < 32; i++) {
+		char c = peekChar();
+		if (c == '\n' || c == '\r' || eof())
+			break;
+		pos++;
+	}
+	return {kept, static_cast<std::size_t>(pos - kept)};
+}
+
+// Skip leading whitespace (advancing lineNumber across newlines), then read
+// up to 32 non-space chars. Same chunked-read contract as nextUntilNewLine:
+// short return means token end; long tokens must be read across multiple
+// calls. Returns an empty view at EOF.
+auto OutputReader::nextUntilSpace() -> std::string_view {
+	for (char c = peekChar(); isSpace(c) && ! eof(); c = peekChar()) {
+		if (c == '\r' || c == '\n')
+			tryNextLine();
+		else
+			pos++;
+		kept = pos;
+	}
+	kept = pos;
+	if (eof())
+		return {kept, 0};
+	for (int i = 0; i < 32; i++) {
+		char c = peekChar();
+		if (isSpace(c) || eof())
+			break;
+		pos++;
+	}
+	return {kept, static_cast<std::size_t>(pos - kept)};
+}
+
+auto OutputReader::nextReal(long double &value) -> int {
+	while ((pos != end || fill()) && isSpace(*pos)) {
+		pos++;
+		kept = pos;
+	}
+
+	if (pos == end)
+		return EOF;
+
+	kept = pos;
+
+	// Enough for the signs, prefixes and words, a pipe may still be on its way
+	while (end - pos < 16 && fill()) {
+	}
+
+	// What fscanf() takes as the number, then hands to strtold() in whole
+	const char *p = pos;
+	bool hex = false;
+	bool hasDigits = false;
+
+	if (*p == '-' || *p == '+')
+		p++;
+
+	if (p != end && toLower(*p) == 'n') {
+		if (! match(p, end, "nan"))
+			return 0;
+
+		value = std::copysign(static_cast<long double>(NAN), *pos == '-' ? -1.0L : 1.0L);
+		pos = p;
+		return 1;
+	}
+
+	if (p != end && toLower(*p) == 'i') {
+		if (! match(p, end, "inf"))
+			return 0;
+		if (p != end && toLower(*p) == 'i' && ! match(p, end, "inity"))
+			return 0;
+
+		value = *pos == '-' ? -HUGE_VALL : HUGE_VALL;
+		pos = p;
+		return 1;
+	}
+
+	if (p != end && *p == '0' && p + 1 != end && toLower(p[1]) == 'x') {
+		p += 2;
+		hex = true;
+	}
+
+	const char exponentChar = hex ? 'p' : 'e';
+	bool hasExponent = false;
+	bool hasDot = false;
+	// An index, filling the buffer may move it
+	auto digits = static_cast<std::size_t>(p - pos);
+	std::size_t i = digits;
+
+	for (; pos + i != end || fill(); i++) {
+		char c = pos[i];
+
+		if (isDigit(c) || (hex && ! hasExponent && isHexDigit(c))) {
+			hasDigits = true;
+		} else if (hasExponent && (c == '+' || c == '-') && toLower(pos[i - 1]) == exponentChar) {
+		} else if (hasDigits && ! hasExponent && toLower(c) == exponentChar) {
+			hasExponent = hasDot = true;
+		} else if (! hasDot && c == '.') {
+			hasDot = true;
+		} else {
+			break;
+		}
+	}
+
+	// strtold() takes at least the "0" of "0x", but fscanf() refuses a bare
+	// prefix
+	if (hex ? i == digits : ! hasDigits)
+		return 0;
+
+	value = convertReal(pos, pos + i, hex);
+	pos += i;
+	return 1;
+}
+
+auto OutputReader::nextChar() -> int {
+	if (pos == end && ! fill())
+		return EOF;
+
+	return static_cast<unsigned char>(*pos++);
+}
+
+void OutputReader::skipEqualLines(OutputReader &other) {
+	if (isEof || other.isEof)
+		return;
+
+	std::size_t length = qMin(end - pos, other.end - other.pos);
+	skip(other, lineBoundary(pos, firstMismatch(pos, other.pos, length)));
+}
+
+void OutputReader::skipEqualTokens(OutputReader &other) {
+	if (isEof || other.isEof)
+		return;
+
+	std::size_t length = qMin(end - pos, other.end - other.pos);
+	skip(other, tokenBoundary(pos, firstMismatch(pos, other.pos, length)));
+}
+
+void OutputReader::skip(OutputReader &other, std::size_t length) {
+	if (length == 0)
+		return;
+
+	auto lines = static_cast<int>(countLineBreaks(pos, length));
+	pos = kept = pos + length;
+	other.pos = other.kept = other.pos + length;
+	lineNumber += lines;
+	other.lineNumber += lines;
+}
+
+auto OutputReader::firstMismatch(const char *a, const char *b, std::size_t n) -> std::size_t {
+	std::size_t i = 0;
+
+	// The C library picks the widest vector instructions the CPU has
+	while (i + 4096 <= n && memcmp(a + i, b + i, 4096) == 0)
+		i += 4096;
+
+#ifdef __AVX2__
+	for (; i + 32 <= n; i += 32) {
+		__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+		__m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+		auto mask = ~static_cast<quint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+
+		if (mask != 0)
+			return i + qCountTrailingZeroBits(mask);
+	}
+#endif
+#ifdef LEMON_SSE2
+	for (; i + 16 <= n; i += 16) {
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+		__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+		auto mask = ~static_cast<quint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) & 0xFFFF;
+
+		if (mask != 0)
+			return i + qCountTrailingZeroBits(mask);
+	}
+#endif
+	for (; i < n; i++)
+		if (a[i] != b[i])
+			return i;
+
+	return n;
+}
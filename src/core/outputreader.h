@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include "processlauncher.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <cstddef>
+#include <string_view>
+
+// Output file reader used by the line/space comparators, reading from a
+// memory mapping of the whole file, or from a pipe while the program is still
+// writing to it.
+//
+// nextUntilNewLine() / nextUntilSpace() return at most 32 chars per call --
+// they do NOT truncate a long line; callers must loop until eof() to consume
+// the whole line/token. The returned views point into the file and stay valid
+// as long as the reader, or into the buffer of a pipe and stay valid until
+// the next read.
+//
+// Comparing chunk by chunk is what decides verdicts and messages, but it is
+// slow on large outputs. Where two files are byte-for-byte the same, their
+// chunks are too, so skipEqualLines() / skipEqualTokens() jump over such a
+// stretch with a vectorized comparison, to where chunks may differ.
+class OutputReader {
+  public:
+	explicit OutputReader(const QString &fileName);
+	// Contents read before, e.g. by AnswerCache
+	explicit OutputReader(const QByteArray &contents);
+#ifndef Q_OS_WIN32
+	// Make a named pipe at `fileName` for the program to write to instead of a
+	// file, and read what comes through it, until `finished` is raised and
+	// the pipe is drained. Not valid if the pipe cannot be made.
+	OutputReader(const QString &fileName, const StopSignal *finished);
+#endif
+	~OutputReader();
+
+	OutputReader(const OutputReader &) = delete;
+	OutputReader &operator=(const OutputReader &) = delete;
+
+	auto valid() const -> bool { return isValid; }
+	auto eof() const -> bool { return isEof; }
+	auto line() const -> int { return lineNumber; }
+	// The whole file
+	auto contents() const -> std::string_view { return {begin, static_cast<std::size_t>(end - begin)}; }
+	auto nextUntilNewLine() -> std::string_view;
+	auto nextUntilSpace() -> std::string_view;
+
+	// The same as fscanf(file, "%Lf", &value) and fgetc(file) with glibc, which
+	// the real number comparator was first written with: 1 if a number was
+	// read, 0 if the input does not start with one, EOF if only spaces are left
+	auto nextReal(long double &value) -> int;
+	auto nextChar() -> int;
+
+	// Advance both readers past the longest common stretch that the chunk
+	// loop of nextUntilNewLine() / nextUntilSpace() would read in step. Only
+	// to be called between two chunks, on readers used the same way.
+	void skipEqualLines(OutputReader &other);
+	void skipEqualTokens(OutputReader &other);
+
+	// Index of the first byte where `a` and `b` differ, `n` if none does
+	static auto firstMismatch(const char *a, const char *b, std::size_t n) -> std::size_t;
+
+  private:
+	QFile file;
+	QByteArray buffer; // Only if the file cannot be mapped, or for a pipe
+	const char *begin{};
+	const char *end{};
+	const char *pos{};
+	bool isValid{};
+	bool isEof{};
+	int lineNumber{1};
+
+	// The read end of a pipe and a write end keeping it open, -1 for a file
+	int descriptor{-1};
+	int writeDescriptor{-1};
+	const StopSignal *finished{};
+	bool isDrained{};
+	// Start of the chunk or number being read, what fill() keeps
+	const char *kept{};
+
+	// Read more from a pipe, blocking until some comes. False at its end,
+	// and always for a file.
+	auto fill() -> bool;
+	auto peekChar() -> char;
+	void tryNextLine();
+	void skip(OutputReader &other, std::size_t length);
+};
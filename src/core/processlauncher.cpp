@@ -0,0 +1,498 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "processlauncher.h"
+#include "base/LemonLog.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QScopeGuard>
+#include <QStandardPaths>
+#include <QThread>
+
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+// posix_spawn_file_actions_addchdir_np() needs glibc 2.29, musl has had it
+// since 1.1.24 but cannot be told apart
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 29)
+#define LEMON_SPAWN_CHDIR
+#endif
+#endif
+#else
+#include <QProcess>
+#endif
+
+#define LEMON_MODULE_NAME "ProcessLauncher"
+
+StopSignal::StopSignal() {
+#ifdef Q_OS_LINUX
+	descriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+}
+
+StopSignal::~StopSignal() {
+#ifdef Q_OS_LINUX
+	if (descriptor != -1)
+		::close(descriptor);
+#endif
+}
+
+void StopSignal::raise() {
+	raised = true;
+
+#ifdef Q_OS_LINUX
+	// Never read back, so it stays readable for every waiter
+	if (descriptor != -1)
+		eventfd_write(descriptor, 1);
+#endif
+}
+
+auto StopSignal::isRaised() const -> bool { return raised; }
+
+auto StopSignal::getDescriptor() const -> int { return descriptor; }
+
+auto StopSignal::waitForAny(std::initializer_list<const StopSignal *> stopSignals, QDeadlineTimer deadline)
+    -> bool {
+	auto raised = [&] {
+		return std::any_of(stopSignals.begin(), stopSignals.end(),
+		                   [](const StopSignal *stopSignal) { return stopSignal->isRaised(); });
+	};
+
+#ifdef Q_OS_LINUX
+	std::vector<pollfd> descriptors;
+
+	for (const StopSignal *stopSignal : stopSignals)
+		descriptors.push_back({stopSignal->getDescriptor(), POLLIN, 0});
+
+	if (std::none_of(descriptors.begin(), descriptors.end(),
+	                 [](const pollfd &descriptor) { return descriptor.fd == -1; })) {
+		while (! raised() && ! deadline.hasExpired())
+			::poll(descriptors.data(), descriptors.size(),
+			       static_cast<int>(qMin<qint64>(deadline.remainingTime(), INT_MAX)));
+
+		return raised();
+	}
+#endif
+
+	// Without eventfds, looked at now and then
+	while (! raised() && ! deadline.hasExpired())
+		QThread::msleep(deadline.isForever() ? 10 : qBound<qint64>(1, deadline.remainingTime(), 10));
+
+	return raised();
+}
+
+ProcessLauncher::ProcessLauncher(const StopSignal *stopSignal) : stopSignal(stopSignal) {}
+
+void ProcessLauncher::setProgram(const QString &_program, const QStringList &_arguments) {
+	program = _program;
+	arguments = _arguments;
+}
+
+void ProcessLauncher::setWorkingDirectory(const QString &directory) { workingDirectory = directory; }
+
+void ProcessLauncher::setProcessEnvironment(const QProcessEnvironment &env) {
+	environment = env;
+	hasEnvironment = true;
+}
+
+auto ProcessLauncher::processEnvironment() const -> QProcessEnvironment {
+	if (! hasEnvironment || environment.inheritsFromParent())
+		return QProcessEnvironment::systemEnvironment();
+
+	return environment;
+}
+
+void ProcessLauncher::setStandardOutputFile(const QString &fileName) { outputFile = fileName; }
+
+void ProcessLauncher::setStandardErrorFile(const QString &fileName) { errorFile = fileName; }
+
+void ProcessLauncher::setMergedChannels(bool merged) { mergedChannels = merged; }
+
+#ifdef Q_OS_LINUX
+
+namespace {
+	// The working directory is changed right before exec, so relative paths
+	// and PATH lookups have to be resolved up front, as QProcess does.
+	auto resolveProgram(const QString &program) -> QString {
+		if (! program.contains('/')) {
+			QString path = QStandardPaths::findExecutable(program);
+			return path.isEmpty() ? program : path;
+		}
+
+		return QFileInfo(program).absoluteFilePath();
+	}
+
+	void closeDescriptor(int &descriptor) {
+		if (descriptor != -1) {
+			::close(descriptor);
+			descriptor = -1;
+		}
+	}
+
+	void watch(int epoll, int descriptor) {
+		if (descriptor == -1)
+			return;
+
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = descriptor;
+		epoll_ctl(epoll, EPOLL_CTL_ADD, descriptor, &event);
+	}
+} // namespace
+
+ProcessLauncher::~ProcessLauncher() {
+	if (running)
+		kill();
+
+	closeDescriptor(pidDescriptor);
+	closeDescriptor(epollDescriptor);
+	closeDescriptor(timerDescriptor);
+	closeDescriptor(outputPipe);
+	closeDescriptor(errorPipe);
+}
+
+void ProcessLauncher::inheritDescriptor(int descriptor, int childDescriptor) {
+	inheritedDescriptors.append(qMakePair(descriptor, childDescriptor));
+}
+
+auto ProcessLauncher::start() -> bool {
+	QByteArray path = QFile::encodeName(resolveProgram(program));
+	QList<QByteArray> argumentData{path};
+	std::vector<char *> argv;
+	QByteArray directory = QFile::encodeName(workingDirectory);
+
+#ifndef LEMON_SPAWN_CHDIR
+	// Let a shell change the directory, with everything passed as arguments
+	// and nothing parsed by it
+	if (! workingDirectory.isEmpty()) {
+		argumentData = {"/bin/sh", "-c", R"(cd -- "$0" && exec "$@")", directory, path};
+		path = "/bin/sh";
+	}
+#endif
+
+	for (const auto &argument : std::as_const(arguments))
+		argumentData.append(QFile::encodeName(argument));
+
+	for (auto &argument : argumentData)
+		argv.push_back(argument.data());
+
+	argv.push_back(nullptr);
+
+	QList<QByteArray> environmentData;
+	std::vector<char *> envp;
+	char **childEnvironment = environ;
+
+	if (hasEnvironment && ! environment.inheritsFromParent()) {
+		for (const auto &variable : environment.toStringList())
+			environmentData.append(variable.toLocal8Bit());
+
+		for (auto &variable : environmentData)
+			envp.push_back(variable.data());
+
+		envp.push_back(nullptr);
+		childEnvironment = envp.data();
+	}
+
+	QByteArray outputName = QFile::encodeName(outputFile);
+	QByteArray errorName = QFile::encodeName(errorFile);
+	int outputFds[2] = {-1, -1};
+	int errorFds[2] = {-1, -1};
+	QList<int> copies;
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+
+	auto cleanUp = qScopeGuard([&] {
+		posix_spawn_file_actions_destroy(&actions);
+		closeDescriptor(outputFds[1]);
+		closeDescriptor(errorFds[1]);
+
+		for (auto &copy : copies)
+			closeDescriptor(copy);
+	});
+
+	posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+
+	if (! outputFile.isEmpty()) {
+		posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, outputName.constData(),
+		                                 O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	} else if (pipe2(outputFds, O_CLOEXEC) == 0) {
+		posix_spawn_file_actions_adddup2(&actions, outputFds[1], STDOUT_FILENO);
+	}
+
+	if (mergedChannels) {
+		posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+	} else if (! errorFile.isEmpty()) {
+		posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, errorName.constData(),
+		                                 O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	} else if (pipe2(errorFds, O_CLOEXEC) == 0) {
+		posix_spawn_file_actions_adddup2(&actions, errorFds[1], STDERR_FILENO);
+	}
+
+	for (auto [descriptor, childDescriptor] : std::as_const(inheritedDescriptors)) {
+		// dup2() onto itself would keep close-on-exec
+		if (descriptor == childDescriptor) {
+			descriptor = fcntl(descriptor, F_DUPFD_CLOEXEC, 0);
+			copies.append(descriptor);
+		}
+
+		posix_spawn_file_actions_adddup2(&actions, descriptor, childDescriptor);
+	}
+
+#ifdef LEMON_SPAWN_CHDIR
+	// Last, so that the files above are opened relative to our own directory
+	if (! workingDirectory.isEmpty())
+		posix_spawn_file_actions_addchdir_np(&actions, directory.constData());
+#endif
+
+	pid_t child = -1;
+
+	if (posix_spawn(&child, path.constData(), &actions, nullptr, argv.data(), childEnvironment) != 0) {
+		closeDescriptor(outputFds[0]);
+		closeDescriptor(errorFds[0]);
+		return false;
+	}
+
+	pid = child;
+	running = true;
+	outputPipe = outputFds[0];
+	errorPipe = errorFds[0];
+
+	if (outputPipe != -1)
+		fcntl(outputPipe, F_SETFL, O_NONBLOCK);
+
+	if (errorPipe != -1)
+		fcntl(errorPipe, F_SETFL, O_NONBLOCK);
+
+#ifdef SYS_pidfd_open
+	pidDescriptor = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#endif
+	epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+	timerDescriptor = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+
+	watch(epollDescriptor, pidDescriptor);
+	watch(epollDescriptor, timerDescriptor);
+	watch(epollDescriptor, outputPipe);
+	watch(epollDescriptor, errorPipe);
+
+	if (stopSignal)
+		watch(epollDescriptor, stopSignal->getDescriptor());
+
+	return true;
+}
+
+auto ProcessLauncher::waitForFinished(int msecs) -> WaitResult {
+	if (! running)
+		return Finished;
+
+	itimerspec deadline{};
+
+	if (msecs >= 0) {
+		deadline.it_value.tv_sec = msecs / 1000;
+		deadline.it_value.tv_nsec = (msecs % 1000) * 1000000L;
+
+		// All zero would disarm the timer instead
+		if (msecs == 0)
+			deadline.it_value.tv_nsec = 1;
+	}
+
+	timerfd_settime(timerDescriptor, 0, &deadline, nullptr);
+
+	while (true) {
+		epoll_event events[8];
+		// Without a pidfd (Linux < 5.3) the exit has to be polled for, and so
+		// does the stop request without an eventfd
+		int timeout = -1;
+
+		if (pidDescriptor == -1)
+			timeout = 1;
+		else if (stopSignal && stopSignal->getDescriptor() == -1)
+			timeout = 10;
+
+		int count = epoll_wait(epollDescriptor, events, 8, timeout);
+		bool timedOut = false;
+
+		for (int i = 0; i < count; i++) {
+			int descriptor = events[i].data.fd;
+
+			if (descriptor == outputPipe)
+				readPipe(outputPipe, standardOutput);
+			else if (descriptor == errorPipe)
+				readPipe(errorPipe, standardError);
+			else if (descriptor == timerDescriptor)
+				timedOut = true;
+		}
+
+		if (reap(false)) {
+			readPipe(outputPipe, standardOutput);
+			readPipe(errorPipe, standardError);
+			return Finished;
+		}
+
+		if (stopSignal && stopSignal->isRaised())
+			return Stopped;
+
+		if (timedOut)
+			return TimedOut;
+	}
+}
+
+void ProcessLauncher::terminate() {
+	sendSignal(SIGTERM);
+	reap(true);
+}
+
+void ProcessLauncher::kill() {
+	sendSignal(SIGKILL);
+	reap(true);
+}
+
+auto ProcessLauncher::exitCode() const -> int {
+	if (WIFSIGNALED(status))
+		return WTERMSIG(status);
+
+	return WEXITSTATUS(status);
+}
+
+auto ProcessLauncher::readAllStandardOutput() -> QByteArray {
+	readPipe(outputPipe, standardOutput);
+	return std::exchange(standardOutput, QByteArray());
+}
+
+auto ProcessLauncher::readAllStandardError() -> QByteArray {
+	readPipe(errorPipe, standardError);
+	return std::exchange(standardError, QByteArray());
+}
+
+// Take whatever is available without blocking: something the program left
+// behind may keep the pipe open long after it exited.
+void ProcessLauncher::readPipe(int &descriptor, QByteArray &buffer) {
+	char chunk[4096];
+
+	while (descriptor != -1) {
+		ssize_t length = ::read(descriptor, chunk, sizeof(chunk));
+
+		if (length > 0) {
+			buffer.append(chunk, length);
+		} else if (length == 0) {
+			epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, descriptor, nullptr);
+			closeDescriptor(descriptor);
+		} else if (errno != EINTR) {
+			break;
+		}
+	}
+}
+
+auto ProcessLauncher::reap(bool block) -> bool {
+	if (! running)
+		return true;
+
+	int result = 0;
+
+	do {
+		result = waitpid(pid, &status, block ? 0 : WNOHANG);
+	} while (result == -1 && errno == EINTR);
+
+	if (result == 0)
+		return false;
+
+	// Someone else reaped it, nothing is known about how it ended
+	if (result == -1)
+		status = 255 << 8;
+
+	running = false;
+	return true;
+}
+
+void ProcessLauncher::sendSignal(int signal) {
+	if (running)
+		::kill(pid, signal);
+}
+
+#else
+
+ProcessLauncher::~ProcessLauncher() = default;
+
+auto ProcessLauncher::start() -> bool {
+	process = std::make_unique<QProcess>();
+
+	if (hasEnvironment)
+		process->setProcessEnvironment(environment);
+
+	if (! workingDirectory.isEmpty())
+		process->setWorkingDirectory(workingDirectory);
+
+	process->setStandardInputFile(QProcess::nullDevice());
+
+	if (! outputFile.isEmpty())
+		process->setStandardOutputFile(outputFile);
+
+	if (mergedChannels)
+		process->setProcessChannelMode(QProcess::MergedChannels);
+	else if (! errorFile.isEmpty())
+		process->setStandardErrorFile(errorFile);
+
+	process->start(program, arguments);
+	return process->waitForStarted(-1);
+}
+
+auto ProcessLauncher::waitForFinished(int msecs) -> WaitResult {
+	QDeadlineTimer deadline(msecs);
+
+	while (process->state() != QProcess::NotRunning) {
+		// Wake up now and then to look at the stop request
+		int slice = deadline.isForever() ? 10 : static_cast<int>(qMin<qint64>(10, deadline.remainingTime()));
+
+		if (process->waitForFinished(slice))
+			break;
+
+		if (stopSignal && stopSignal->isRaised())
+			return Stopped;
+
+		if (deadline.hasExpired())
+			return TimedOut;
+	}
+
+	return Finished;
+}
+
+void ProcessLauncher::terminate() {
+	process->terminate();
+	process->waitForFinished(-1);
+}
+
+void ProcessLauncher::kill() {
+	process->kill();
+	process->waitForFinished(-1);
+}
+
+auto ProcessLauncher::exitCode() const -> int { return process->exitCode(); }
+
+auto ProcessLauncher::readAllStandardOutput() -> QByteArray { return process->readAllStandardOutput(); }
+
+auto ProcessLauncher::readAllStandardError() -> QByteArray { return process->readAllStandardError(); }
+
+#endif
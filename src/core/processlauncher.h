@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QDeadlineTimer>
+#include <QList>
+#include <QPair>
+#include <QProcessEnvironment>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+
+#ifndef Q_OS_LINUX
+class QProcess;
+#endif
+
+// A stop request for everything judging one test case. Besides reading as a
+// flag, it wakes up ProcessLauncher::waitForFinished() and waitForAny() at once.
+class StopSignal {
+  public:
+	StopSignal();
+	~StopSignal();
+	StopSignal(const StopSignal &) = delete;
+	StopSignal &operator=(const StopSignal &) = delete;
+
+	void raise();
+	bool isRaised() const;
+	explicit operator bool() const { return isRaised(); }
+	// An eventfd that becomes readable once raised, -1 if not supported
+	int getDescriptor() const;
+
+	// Sleeps until one of `stopSignals` is raised, false if `deadline` expires first
+	static bool waitForAny(std::initializer_list<const StopSignal *> stopSignals,
+	                       QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+
+  private:
+	std::atomic<bool> raised{false};
+	int descriptor{-1};
+};
+
+// Starts a program and waits for it on the calling thread, without an event
+// loop. On Linux it is spawned with posix_spawn and waited for through a
+// pidfd in an epoll set, next to a timerfd for the deadline and the eventfd
+// of the StopSignal, so that each of them is noticed as soon as it happens.
+// Elsewhere it wraps QProcess.
+//
+// Standard output and error are captured unless redirected to a file;
+// standard input is always empty.
+class ProcessLauncher {
+  public:
+	enum WaitResult { Finished, TimedOut, Stopped };
+
+	explicit ProcessLauncher(const StopSignal *stopSignal = nullptr);
+	~ProcessLauncher();
+	ProcessLauncher(const ProcessLauncher &) = delete;
+	ProcessLauncher &operator=(const ProcessLauncher &) = delete;
+
+	void setProgram(const QString &, const QStringList &);
+	void setWorkingDirectory(const QString &);
+	void setProcessEnvironment(const QProcessEnvironment &);
+	QProcessEnvironment processEnvironment() const;
+	void setStandardOutputFile(const QString &);
+	void setStandardErrorFile(const QString &);
+	void setMergedChannels(bool);
+#ifdef Q_OS_LINUX
+	// Let the program inherit `descriptor` as `childDescriptor`
+	void inheritDescriptor(int descriptor, int childDescriptor);
+#endif
+
+	bool start();
+	// Waits at most `msecs` milliseconds, or forever if negative
+	WaitResult waitForFinished(int msecs = -1);
+	// Send the signal and wait until the program is gone
+	void terminate();
+	void kill();
+
+	int exitCode() const;
+	QByteArray readAllStandardOutput();
+	QByteArray readAllStandardError();
+
+  private:
+	const StopSignal *stopSignal;
+	QString program;
+	QStringList arguments;
+	QString workingDirectory;
+	QProcessEnvironment environment;
+	bool hasEnvironment{};
+	QString outputFile;
+	QString errorFile;
+	bool mergedChannels{};
+
+#ifdef Q_OS_LINUX
+	QList<QPair<int, int>> inheritedDescriptors;
+	int pid{-1};
+	int pidDescriptor{-1};
+	int epollDescriptor{-1};
+	int timerDescriptor{-1};
+	int outputPipe{-1};
+	int errorPipe{-1};
+	QByteArray standardOutput;
+	QByteArray standardError;
+	int status{};
+	bool running{};
+
+	void readPipe(int &, QByteArray &);
+	bool reap(bool block);
+	void sendSignal(int);
+#else
+	std::unique_ptr<QProcess> process;
+#endif
+};
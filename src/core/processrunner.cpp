@@ -13,14 +13,31 @@
 #include "processrunner_unix.h"
 #endif
 
-ProcessRunner::ProcessRunner(ProcessRunnerConfig cfg, const std::atomic<bool> &stop)
+#ifdef Q_OS_LINUX
+#include "cgroup.h"
+#include "processrunner_cgroup.h"
+#endif
+
+ProcessRunner::ProcessRunner(ProcessRunnerConfig cfg, const StopSignal &stop)
     : config(std::move(cfg)), stopFlag(stop) {}
 
 auto ProcessRunner::create(ProcessRunnerConfig config,
-                           const std::atomic<bool> &stopFlag) -> std::unique_ptr<ProcessRunner> {
+                           const StopSignal &stopFlag) -> std::unique_ptr<ProcessRunner> {
 #ifdef Q_OS_WIN32
 	return std::make_unique<WinProcessRunner>(std::move(config), stopFlag);
 #else
+#ifdef Q_OS_LINUX
+	if (Cgroup::isAvailable())
+		return std::make_unique<CgroupProcessRunner>(std::move(config), stopFlag);
+#endif
 	return std::make_unique<UnixProcessRunner>(std::move(config), stopFlag);
 #endif
 }
+
+auto ProcessRunner::bindsReadOnlyFiles() -> bool {
+#ifdef Q_OS_LINUX
+	return true;
+#else
+	return false;
+#endif
+}
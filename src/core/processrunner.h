@@ -8,10 +8,11 @@
 #pragma once
 
 #include "base/LemonType.hpp"
+#include "processlauncher.h"
 #include <QProcessEnvironment>
 #include <QString>
+#include <QStringList>
 #include <QtGlobal>
-#include <atomic>
 #include <memory>
 
 struct ProcessRunnerConfig {
@@ -30,6 +31,16 @@ struct ProcessRunnerConfig {
 	QString inputFileName;
 	QString outputFileName;
 	bool interpreterAsWatcher{};
+	// Pass the arguments through a shell instead of splitting them into words
+	// and executing the program directly. Only the watcher (Unix) has a choice.
+	bool runInShell{};
+	// Files of the working directory the program may only read. Only
+	// honoured when bindsReadOnlyFiles() is true.
+	QStringList readOnlyFiles;
+	// Wall-clock milliseconds after which a program that is still running,
+	// as when it waits on an interactor waiting on it, is stopped and over
+	// the time limit. 0 for none. Only the watcher (Unix) honours it.
+	int wallTimeLimit{};
 };
 
 struct ProcessRunnerResult {
@@ -42,15 +53,19 @@ struct ProcessRunnerResult {
 
 class ProcessRunner {
   public:
-	ProcessRunner(ProcessRunnerConfig config, const std::atomic<bool> &stopFlag);
+	ProcessRunner(ProcessRunnerConfig config, const StopSignal &stopFlag);
 	virtual ~ProcessRunner() = default;
 
 	virtual ProcessRunnerResult run() = 0;
 
 	static std::unique_ptr<ProcessRunner> create(ProcessRunnerConfig config,
-	                                             const std::atomic<bool> &stopFlag);
+	                                             const StopSignal &stopFlag);
+
+	// Whether the program runs in a sandbox that mounts readOnlyFiles and the
+	// input file read-only, instead of needing private copies of them.
+	static bool bindsReadOnlyFiles();
 
   protected:
 	ProcessRunnerConfig config;
-	const std::atomic<bool> &stopFlag;
+	const StopSignal &stopFlag;
 };
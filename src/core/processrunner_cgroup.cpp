@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#ifdef Q_OS_LINUX
+
+#include "processrunner_cgroup.h"
+#include "base/LemonLog.hpp"
+#include "core/cgroup.h"
+
+#define LEMON_MODULE_NAME "ProcessRunner"
+
+namespace {
+	// Threads count as well, leave room for the JVM and the like
+	const int maxProcesses = 256;
+} // namespace
+
+CgroupProcessRunner::CgroupProcessRunner(ProcessRunnerConfig cfg, const StopSignal &stop)
+    : UnixProcessRunner(std::move(cfg), stop), cgroup(Cgroup::create()) {
+	if (! cgroup)
+		return;
+
+	QByteArray memoryMax = "max";
+
+	if (config.memoryLimit > 0)
+		memoryMax = QByteArray::number(1LL * config.memoryLimit * 1024 * 1024);
+
+	if (! cgroup->write("memory.max", memoryMax) ||
+	    ! cgroup->write("pids.max", QByteArray::number(maxProcesses))) {
+		WARN("Cannot set the limits of the cgroup, falling back to rlimits");
+		cgroup.reset();
+		return;
+	}
+
+	// Swapping would only hide a memory limit exceeded. The file is missing
+	// without swap accounting, which is just as good.
+	cgroup->write("memory.swap.max", "0");
+}
+
+CgroupProcessRunner::~CgroupProcessRunner() = default;
+
+auto CgroupProcessRunner::namespaceArguments() -> QStringList {
+	if (! cgroup)
+		return UnixProcessRunner::namespaceArguments();
+
+	// Everything --unshare-all does except the cgroup namespace: before Linux
+	// 5.16 the watcher's write to cgroup.procs is checked against the
+	// namespace it writes from, and the leaf is outside of a new one.
+	return {"--unshare-user-try", "--unshare-ipc", "--unshare-pid", "--unshare-net", "--unshare-uts"};
+}
+
+auto CgroupProcessRunner::procsDescriptor() -> int { return cgroup ? cgroup->getProcsDescriptor() : -1; }
+
+auto CgroupProcessRunner::usageCheckInterval() -> int { return cgroup ? 10 : -1; }
+
+void CgroupProcessRunner::checkUsage() {
+	if (! cgroup || killedForTime)
+		return;
+
+	// Anything that may still be rejudged has to run to the end, see
+	// JudgingThread::judgeTraditionalTask()
+	double limit = qMax(config.timeLimit * (1 + config.extraTimeRatio),
+	                    config.timeLimit + 1000 * config.extraTimeRatio);
+
+	if (cgroup->read("cpu.stat", "user_usec") > limit * 1000) {
+		killedForTime = true;
+		cgroup->kill();
+	}
+}
+
+void CgroupProcessRunner::killProcess() {
+	if (cgroup)
+		cgroup->kill();
+
+	UnixProcessRunner::killProcess();
+}
+
+void CgroupProcessRunner::collectResult(ProcessRunnerResult &res) {
+	if (! cgroup || res.result == CannotStartProgram)
+		return;
+
+	// Same clock as the watcher's ru_utime, but in microseconds and
+	// including every child of the program
+	qint64 userTime = cgroup->read("cpu.stat", "user_usec");
+
+	if (userTime >= 0)
+		res.timeUsed = static_cast<int>(userTime / 1000);
+
+	if (killedForTime) {
+		res.result = TimeLimitExceeded;
+		res.score = 0;
+		return;
+	}
+
+	if (cgroup->read("memory.events", "oom_kill") > 0) {
+		res.result = MemoryLimitExceeded;
+		res.score = 0;
+	}
+
+	// The watcher cannot tell when the program was killed
+	if (res.memoryUsed < 0)
+		res.memoryUsed = cgroup->read("memory.peak");
+}
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#ifdef Q_OS_LINUX
+
+#include "processrunner_unix.h"
+
+#include <memory>
+
+class Cgroup;
+
+// Runs the program through the usual bwrap + watcher chain, but inside a
+// cgroup v2 leaf: memory.max and pids.max replace RLIMIT_AS, the CPU time
+// comes from cpu.stat with microsecond precision and every process the
+// program leaves behind is killed with the cgroup. If the leaf cannot be
+// created it behaves exactly like UnixProcessRunner.
+class CgroupProcessRunner : public UnixProcessRunner {
+  public:
+	CgroupProcessRunner(ProcessRunnerConfig config, const StopSignal &stopFlag);
+	~CgroupProcessRunner() override;
+
+  protected:
+	QStringList namespaceArguments() override;
+	int procsDescriptor() override;
+	int usageCheckInterval() override;
+	void checkUsage() override;
+	void killProcess() override;
+	void collectResult(ProcessRunnerResult &) override;
+
+  private:
+	std::unique_ptr<Cgroup> cgroup;
+	bool killedForTime{};
+};
+
+#endif
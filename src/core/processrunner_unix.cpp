@@ -11,38 +11,33 @@
 
 #include "processrunner_unix.h"
 #include "base/LemonLog.hpp"
+#include "core/fileprovisioner.h"
+#ifdef Q_OS_LINUX
+#include "core/sandboxzygote.h"
+#endif
 
-#include <QCoreApplication>
-#include <QDebug>
-#include <QElapsedTimer>
+#include <QDeadlineTimer>
 #include <QFile>
 #include <QFileInfo>
-#include <QProcess>
 #include <QStandardPaths>
 #include <QTextStream>
-#include <QThread>
-#include <QUuid>
 #include <QtMath>
 
 #define LEMON_MODULE_NAME "ProcessRunner"
 
-ProcessRunnerResult UnixProcessRunner::run() {
-	ProcessRunnerResult res;
-	res.result = CorrectAnswer;
-	int extraTime = qCeil(qMax(2000, config.timeLimit * 2) * config.extraTimeRatio);
-
 #ifdef Q_OS_LINUX
-	// TODO: rewrite with cgroup
-	QFile watcher(config.workingDirectory + QUuid::createUuid().toString(QUuid::Id128));
 
-	if (config.interpreterAsWatcher) {
-		QFile::copy(config.executableFile, watcher.fileName());
-	} else {
-		QFile::copy(":/watcher/watcher_unix", watcher.fileName());
-	}
+namespace {
+	// Where the watcher finds cgroup.procs
+	const int childProcsDescriptor = 3;
+} // namespace
+
+auto UnixProcessRunner::bwrapPath() -> QString {
+	static const QString path = QStandardPaths::findExecutable("bwrap");
+	return path;
+}
 
-	watcher.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner);
-	auto *runner = new QProcess();
+auto UnixProcessRunner::sandboxArguments(const QString &watcherFile) -> QStringList {
 	QStringList argumentsList;
 
 	argumentsList << "--dev" << "/dev";
@@ -53,25 +48,36 @@ ProcessRunnerResult UnixProcessRunner::run() {
 	argumentsList << "--symlink" << "/usr/bin" << "/bin";
 	argumentsList << "--symlink" << "/usr/sbin" << "/sbin";
 	argumentsList << "--tmpfs" << "/tmp";
+	// Mounted into the sandbox rather than copied into the working directory
+	argumentsList << "--ro-bind" << watcherFile << sandboxWatcher;
 
-	argumentsList << "--unshare-all" << "--die-with-parent";
+	return argumentsList;
+}
 
-	argumentsList << "--chdir" << config.workingDirectory;
+#endif
 
-	argumentsList << "--bind" << config.workingDirectory << config.workingDirectory;
+// The arguments of the watcher, see unix/watcher_unix.cpp. `workingDirectory`
+// is where the sandbox shows config.workingDirectory, `inputFile` where it
+// shows the input file.
+auto UnixProcessRunner::watcherArguments(const QString &workingDirectory, const QString &inputFile) const
+    -> QStringList {
+	QString executableFile = config.executableFile;
+	QString arguments = config.arguments;
 
-	if (config.standardInputCheck) {
-		argumentsList << "--ro-bind" << QFileInfo(config.inputFile).absoluteFilePath()
-		              << QFileInfo(config.inputFile).absoluteFilePath();
+	if (workingDirectory != config.workingDirectory) {
+		if (executableFile.startsWith(config.workingDirectory))
+			executableFile.replace(0, config.workingDirectory.length(), workingDirectory);
+
+		arguments.replace(config.workingDirectory, workingDirectory);
 	}
 
-	argumentsList << watcher.fileName();
+	QStringList argumentsList;
 
-	argumentsList << config.executableFile;
-	argumentsList << config.arguments;
+	argumentsList << executableFile;
+	argumentsList << arguments;
 
 	if (config.standardInputCheck) {
-		argumentsList << QFileInfo(config.inputFile).absoluteFilePath();
+		argumentsList << inputFile;
 	} else {
 		argumentsList << "";
 	}
@@ -100,129 +106,195 @@ ProcessRunnerResult UnixProcessRunner::run() {
 		argumentsList << config.outputFileName;
 	}
 
-	qDebug() << argumentsList;
+	if (config.runInShell)
+		argumentsList << "shell";
+
+	return argumentsList;
+}
+
+// Sleeps until the watcher exits, the judge is stopped or the next usage
+// check is due, whichever comes first. False unless the watcher finished.
+template <typename Process>
+auto UnixProcessRunner::waitForWatcher(Process &process, ProcessRunnerResult &res) -> bool {
+	int extraTime = qCeil(qMax(2000, config.timeLimit * 2) * config.extraTimeRatio);
+	// Using rlimit to limit CPU time can only be accurate to seconds,
+	// so here it is rounded up to an integer second.
+	long long killTimeLimit = (config.timeLimit + 999) / 1000 * 1000 + extraTime;
+	bool wallTimed = config.wallTimeLimit > 0;
+	QDeadlineTimer deadline(wallTimed ? config.wallTimeLimit : killTimeLimit);
+	ProcessLauncher::WaitResult status = ProcessLauncher::TimedOut;
+
+	while (! deadline.hasExpired()) {
+		int interval = usageCheckInterval();
+		int remaining = static_cast<int>(deadline.remainingTime());
+		status = process.waitForFinished(interval < 0 ? remaining : qMin(interval, remaining));
+
+		if (status != ProcessLauncher::TimedOut)
+			break;
+
+		checkUsage();
+	}
+
+	if (status == ProcessLauncher::Stopped) {
+		killProcess();
+		return false;
+	}
+
+	// Still there at the wall-clock limit, idle or waiting for what never comes
+	if (status != ProcessLauncher::Finished && wallTimed) {
+		killProcess();
+		res.score = 0;
+		res.timeUsed = res.memoryUsed = -1;
+		res.result = TimeLimitExceeded;
+		res.message = "";
+		return false;
+	}
 
-	QString bwrapPath = QStandardPaths::findExecutable("bwrap");
-	if (bwrapPath.isEmpty()) {
+	if (status != ProcessLauncher::Finished) {
+		killProcess();
 		res.score = 0;
+		res.timeUsed = res.memoryUsed = -1;
+		// Watcher usually needs to handle the situation of program timeout and kill it. Therefore, it is
+		// abnormal for watcher to timeout itself, and report FAIL instead of TLE.
 		res.result = CannotStartProgram;
-		res.message = QObject::tr("bwrap not found. Please install bubblewrap.");
-		delete runner;
-		return res;
+		res.message = "Watcher time limit exceeded";
+		return false;
 	}
 
-	runner->setProcessEnvironment(config.environment);
-	runner->setWorkingDirectory(config.workingDirectory);
-	runner->start(bwrapPath, argumentsList);
+	return true;
+}
 
-#else
+ProcessRunnerResult UnixProcessRunner::run() {
+	ProcessRunnerResult res;
+	res.result = CorrectAnswer;
 
-	QFile watcher(config.workingDirectory + QUuid::createUuid().toString(QUuid::Id128));
+#ifdef Q_OS_LINUX
+	// Most test cases fit into the sandbox kept ready for this judging slot,
+	// which saves setting up the namespaces again
+	if (auto *slot = SandboxZygote::current(); slot && ! config.interpreterAsWatcher && slot->enter(config)) {
+		QStringList argumentsList = watcherArguments(slot->getWorkingDirectory(), slot->getInputFile());
+
+		if (slot->send(argumentsList, config.environment, procsDescriptor(), &stopFlag)) {
+			zygote = slot;
+			bool finished = waitForWatcher(*slot, res);
+			zygote = nullptr;
+			slot->leave();
+
+			if (finished) {
+				res.timeUsed = slot->getTimeUsed();
+				res.memoryUsed = slot->getMemoryUsed();
+				res.message = slot->getMessage();
+				readResult(slot->exitCode(), res);
+			}
 
-	if (config.interpreterAsWatcher) {
-		QFile::copy(config.executableFile, watcher.fileName());
-	} else {
-		QFile::copy(":/watcher/watcher_unix", watcher.fileName());
+			return res;
+		}
+
+		slot->leave();
 	}
 
-	watcher.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner);
-	auto *runner = new QProcess();
-	QStringList argumentsList;
+	QString watcherFile = config.interpreterAsWatcher ? QFileInfo(config.executableFile).absoluteFilePath()
+	                                                  : FileProvisioner::watcherFile();
 
-	argumentsList << config.executableFile;
-	argumentsList << config.arguments;
+	if (watcherFile.isEmpty()) {
+		res.score = 0;
+		res.result = CannotStartProgram;
+		res.message = "Cannot extract the watcher";
+		return res;
+	}
+
+	QStringList argumentsList = sandboxArguments(watcherFile);
+
+	argumentsList << namespaceArguments() << "--die-with-parent";
+
+	argumentsList << "--chdir" << config.workingDirectory;
+
+	argumentsList << "--bind" << config.workingDirectory << config.workingDirectory;
+
+	// Shared with files outside the sandbox (see TaskJudger), keep them intact
+	for (const auto &file : config.readOnlyFiles)
+		argumentsList << "--ro-bind" << file << file;
+
+	QString inputFile = QFileInfo(config.inputFile).absoluteFilePath();
 
 	if (config.standardInputCheck) {
-		argumentsList << QFileInfo(config.inputFile).absoluteFilePath();
+		argumentsList << "--ro-bind" << inputFile << inputFile;
 	} else {
-		argumentsList << "";
+		argumentsList << "--ro-bind" << inputFile << config.workingDirectory + config.inputFileName;
 	}
 
-	if (config.standardOutputCheck) {
-		argumentsList << "_tmpout";
-	} else {
-		argumentsList << "";
+	argumentsList << sandboxWatcher;
+	argumentsList << watcherArguments(config.workingDirectory, inputFile);
+
+	if (bwrapPath().isEmpty()) {
+		res.score = 0;
+		res.result = CannotStartProgram;
+		res.message = QObject::tr("bwrap not found. Please install bubblewrap.");
+		return res;
 	}
 
-	argumentsList << "_tmperr";
-	argumentsList << QString("%1").arg(config.timeLimit);
-	argumentsList << QString("%1").arg(config.memoryLimit);
-	argumentsList << QString("%1").arg(config.rawTimeLimit);
-	argumentsList << QString("%1").arg(config.rawMemoryLimit);
+	ProcessLauncher runner(&stopFlag);
+	QProcessEnvironment environment = config.environment;
 
-	if (config.standardInputCheck) {
-		argumentsList << "";
-	} else {
-		argumentsList << config.inputFileName;
-	}
+	if (int descriptor = procsDescriptor(); descriptor != -1) {
+		if (environment.inheritsFromParent())
+			environment = QProcessEnvironment::systemEnvironment();
 
-	if (config.standardOutputCheck) {
-		argumentsList << "";
-	} else {
-		argumentsList << config.outputFileName;
+		environment.insert("LEMON_CGROUP_FD", QString::number(childProcsDescriptor));
+		// Only this child inherits the descriptor, not the ones other workers spawn
+		runner.inheritDescriptor(descriptor, childProcsDescriptor);
 	}
 
-	qDebug() << argumentsList;
+	runner.setProgram(bwrapPath(), argumentsList);
+	runner.setProcessEnvironment(environment);
 
-	runner->setProcessEnvironment(config.environment);
-	runner->setWorkingDirectory(config.workingDirectory);
-	runner->start(watcher.fileName(), argumentsList);
+#else
 
-#endif
+	QString watcherFile =
+	    config.interpreterAsWatcher ? config.executableFile : FileProvisioner::watcherFile();
 
-	if (! runner->waitForStarted(-1)) {
-		delete runner;
+	if (watcherFile.isEmpty()) {
 		res.score = 0;
 		res.result = CannotStartProgram;
-		res.message = "Start runner failed";
+		res.message = "Cannot extract the watcher";
 		return res;
 	}
 
-	bool isProgramFinishedInExtraTimeLimit = false;
-	QElapsedTimer timer;
-	timer.start();
+	QStringList argumentsList =
+	    watcherArguments(config.workingDirectory, QFileInfo(config.inputFile).absoluteFilePath());
 
-	// Using rlimit to limit CPU time can only be accurate to seconds,
-	// so here it is rounded up to an integer second.
-	long long killTimeLimit = (config.timeLimit + 999) / 1000 * 1000 + extraTime;
-	while (timer.elapsed() <= killTimeLimit) {
-		if (runner->waitForFinished(10)) {
-			isProgramFinishedInExtraTimeLimit = true;
-			break;
-		}
+	ProcessLauncher runner(&stopFlag);
+	runner.setProgram(watcherFile, argumentsList);
+	runner.setProcessEnvironment(config.environment);
 
-		QCoreApplication::processEvents();
+#endif
 
-		if (stopFlag) {
-			runner->terminate();
-			runner->waitForFinished(-1);
-			delete runner;
+	runner.setWorkingDirectory(config.workingDirectory);
 
-			return res;
-		}
-	}
-
-	if (! isProgramFinishedInExtraTimeLimit) {
-		runner->terminate();
-		runner->waitForFinished(-1);
-		delete runner;
+	if (! runner.start()) {
 		res.score = 0;
-		res.timeUsed = res.memoryUsed = -1;
-		// Watcher usually needs to handle the situation of program timeout and kill it. Therefore, it is
-		// abnormal for watcher to timeout itself, and report FAIL instead of TLE.
 		res.result = CannotStartProgram;
-		res.message = "Watcher time limit exceeded";
+		res.message = "Start runner failed";
 		return res;
 	}
 
-	{
-		QString out = QString::fromLocal8Bit(runner->readAllStandardOutput().constData());
+	launcher = &runner;
+	bool finished = waitForWatcher(runner, res);
+	launcher = nullptr;
+
+	if (finished) {
+		QString out = QString::fromLocal8Bit(runner.readAllStandardOutput().constData());
 		QTextStream stream(&out, QIODevice::ReadOnly);
 		stream >> res.timeUsed >> res.memoryUsed;
+		res.message = QString::fromLocal8Bit(runner.readAllStandardError().constData());
+		readResult(runner.exitCode(), res);
 	}
 
-	res.message = QString::fromLocal8Bit(runner->readAllStandardError().constData());
+	return res;
+}
 
+// The usage and the message are already in `res`
+void UnixProcessRunner::readResult(int code, ProcessRunnerResult &res) {
 	enum : int {
 		RS_AC = 0,
 		RS_FAIL = 1,
@@ -231,8 +303,6 @@ ProcessRunnerResult UnixProcessRunner::run() {
 		RS_MLE = 4,
 	};
 
-	int code = runner->exitCode();
-
 	switch (code) {
 		case RS_RE:
 			res.result = RunTimeError;
@@ -264,9 +334,29 @@ ProcessRunnerResult UnixProcessRunner::run() {
 			break;
 	}
 
-	delete runner;
+	collectResult(res);
+}
 
-	return res;
+auto UnixProcessRunner::namespaceArguments() -> QStringList { return {"--unshare-all"}; }
+
+auto UnixProcessRunner::procsDescriptor() -> int { return -1; }
+
+auto UnixProcessRunner::usageCheckInterval() -> int { return -1; }
+
+void UnixProcessRunner::checkUsage() {}
+
+void UnixProcessRunner::killProcess() {
+#ifdef Q_OS_LINUX
+	if (zygote) {
+		zygote->kill();
+		return;
+	}
+#endif
+
+	if (launcher)
+		launcher->terminate();
 }
 
+void UnixProcessRunner::collectResult(ProcessRunnerResult & /*res*/) {}
+
 #endif
@@ -11,10 +11,43 @@
 
 #include "processrunner.h"
 
+class SandboxZygote;
+
 class UnixProcessRunner : public ProcessRunner {
   public:
 	using ProcessRunner::ProcessRunner;
 	ProcessRunnerResult run() override;
+
+#ifdef Q_OS_LINUX
+	// Where the sandboxes find the watcher
+	static constexpr const char *sandboxWatcher = "/tmp/.watcher";
+
+	// Empty if bubblewrap is not installed
+	static QString bwrapPath();
+	// The part of the bwrap command line every sandbox shares: read-only
+	// system directories, a private /tmp and the watcher in it
+	static QStringList sandboxArguments(const QString &watcherFile);
+#endif
+
+  protected:
+	// Extension points for CgroupProcessRunner, all called from run()
+	virtual QStringList namespaceArguments();
+	// cgroup.procs to move the program into, -1 for none
+	virtual int procsDescriptor();
+	// How often checkUsage() wants to run in milliseconds, -1 for never
+	virtual int usageCheckInterval();
+	virtual void checkUsage();
+	// Kill the watcher started by run()
+	virtual void killProcess();
+	virtual void collectResult(ProcessRunnerResult &);
+
+  private:
+	ProcessLauncher *launcher{};
+	SandboxZygote *zygote{};
+
+	QStringList watcherArguments(const QString &workingDirectory, const QString &inputFile) const;
+	template <typename Process> bool waitForWatcher(Process &, ProcessRunnerResult &);
+	void readResult(int code, ProcessRunnerResult &);
 };
 
 #endif
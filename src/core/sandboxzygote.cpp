@@ -0,0 +1,333 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#ifdef Q_OS_LINUX
+
+#include "sandboxzygote.h"
+#include "base/LemonLog.hpp"
+#include "core/fileprovisioner.h"
+#include "core/processrunner_unix.h"
+
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LEMON_MODULE_NAME "SandboxZygote"
+
+namespace {
+	thread_local SandboxZygote *currentZygote = nullptr;
+
+	// Copying a larger input costs more than a sandbox of its own, which
+	// mounts it instead
+	const qint64 maxCopiedInput = 4 * 1024 * 1024;
+
+	auto encode(const QString &path) -> QByteArray { return QFile::encodeName(path); }
+
+	// Remove a file or a whole directory, without following symbolic links
+	void removeEntry(const QString &path) {
+		QFileInfo info(path);
+
+		if (info.isDir() && ! info.isSymLink())
+			QDir(path).removeRecursively();
+		else
+			QFile::remove(path);
+	}
+} // namespace
+
+SandboxZygote::SandboxZygote() {
+	currentZygote = this;
+
+	if (slotDir.isValid() && QDir(slotDir.path()).mkdir("ro"))
+		start();
+}
+
+SandboxZygote::~SandboxZygote() {
+	kill();
+
+	if (currentZygote == this)
+		currentZygote = nullptr;
+}
+
+auto SandboxZygote::current() -> SandboxZygote * {
+	if (currentZygote && currentZygote->slotDir.isValid())
+		return currentZygote;
+
+	return nullptr;
+}
+
+auto SandboxZygote::start() -> bool {
+	QString watcherFile = FileProvisioner::watcherFile();
+
+	if (watcherFile.isEmpty() || UnixProcessRunner::bwrapPath().isEmpty())
+		return false;
+
+	int sockets[2];
+
+	if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0)
+		return false;
+
+	const QString slot = slotDir.path();
+	QStringList arguments = UnixProcessRunner::sandboxArguments(watcherFile);
+
+	// Everything --unshare-all does except the cgroup namespace, which would
+	// keep the watcher from moving programs into the cgroups of the judge (see
+	// CgroupProcessRunner::namespaceArguments())
+	arguments << "--unshare-user-try" << "--unshare-ipc" << "--unshare-pid" << "--unshare-net"
+	          << "--unshare-uts" << "--die-with-parent";
+	arguments << "--bind" << slot << slot;
+	arguments << "--ro-bind" << slot + "/ro" << slot + "/ro";
+	arguments << "--chdir" << slot;
+	arguments << UnixProcessRunner::sandboxWatcher << "--zygote" << "/tmp" << "/dev/shm";
+
+	sandbox = std::make_unique<ProcessLauncher>();
+	sandbox->setProgram(UnixProcessRunner::bwrapPath(), arguments);
+	sandbox->setStandardOutputFile(QProcess::nullDevice());
+	sandbox->setStandardErrorFile(QProcess::nullDevice());
+	sandbox->inheritDescriptor(sockets[1], STDIN_FILENO);
+
+	bool started = sandbox->start();
+	::close(sockets[1]);
+
+	if (! started) {
+		WARN("Cannot start the sandbox zygote");
+		::close(sockets[0]);
+		sandbox.reset();
+		return false;
+	}
+
+	socket = sockets[0];
+	return true;
+}
+
+void SandboxZygote::kill() {
+	// Killing bwrap takes the whole PID namespace with it
+	sandbox.reset();
+
+	if (socket != -1) {
+		::close(socket);
+		socket = -1;
+	}
+}
+
+auto SandboxZygote::enter(const ProcessRunnerConfig &config) -> bool {
+	if (socket == -1 && ! start())
+		return false;
+
+	const QString slot = slotDir.path();
+	const QString work = slot + "/work";
+	const QString input = QFileInfo(config.inputFile).absoluteFilePath();
+
+	// Hard-linked if on the same filesystem, in "ro" the program cannot
+	// write through the link. Otherwise copied, unless it is a FIFO or the
+	// like, which copying would drain: that goes to a sandbox of its own.
+	if (::link(encode(input).constData(), encode(getInputFile()).constData()) != 0) {
+		QFileInfo info(input);
+
+		if (! info.isFile() || info.size() > maxCopiedInput || ! QFile::copy(input, getInputFile())) {
+			QFile::remove(getInputFile());
+			return false;
+		}
+	}
+
+	if (::rename(encode(QDir(config.workingDirectory).absolutePath()).constData(), encode(work).constData()) !=
+	    0) {
+		QFile::remove(getInputFile());
+		return false;
+	}
+
+	workingDirectory = config.workingDirectory;
+
+	// Shared with files outside the sandbox (see TaskJudger), so they move to
+	// "ro" and are linked from where the program expects them
+	for (const auto &file : config.readOnlyFiles) {
+		QString name = QFileInfo(file).fileName();
+
+		if (::rename(encode(work + "/" + name).constData(), encode(slot + "/ro/" + name).constData()) == 0) {
+			QFile::link(slot + "/ro/" + name, work + "/" + name);
+			movedFiles.append(name);
+		}
+	}
+
+	if (! config.standardInputCheck) {
+		inputLink = work + "/" + config.inputFileName;
+		removeEntry(inputLink);
+		QFile::link(getInputFile(), inputLink);
+	}
+
+	return true;
+}
+
+void SandboxZygote::leave() {
+	const QString slot = slotDir.path();
+	const QString work = slot + "/work";
+
+	if (! inputLink.isEmpty())
+		removeEntry(inputLink);
+
+	for (const auto &name : std::as_const(movedFiles)) {
+		removeEntry(work + "/" + name);
+		::rename(encode(slot + "/ro/" + name).constData(), encode(work + "/" + name).constData());
+	}
+
+	QFile::remove(getInputFile());
+
+	// The program may have replaced its working directory, by a symbolic link
+	// to somewhere outside the sandbox even
+	QString target = QDir(workingDirectory).absolutePath();
+	QFileInfo info(work);
+
+	if (! info.isDir() || info.isSymLink() ||
+	    ::rename(encode(work).constData(), encode(target).constData()) != 0) {
+		removeEntry(work);
+		QDir().mkpath(target);
+	}
+
+	// Whatever the program left next to its working directory
+	const QStringList entries =
+	    QDir(slot).entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+
+	for (const auto &entry : entries)
+		if (entry != "ro")
+			removeEntry(slot + "/" + entry);
+
+	workingDirectory.clear();
+	movedFiles.clear();
+	inputLink.clear();
+}
+
+auto SandboxZygote::getWorkingDirectory() const -> QString { return slotDir.path() + "/work/"; }
+
+auto SandboxZygote::getInputFile() const -> QString { return slotDir.path() + "/ro/input"; }
+
+auto SandboxZygote::send(const QStringList &arguments, const QProcessEnvironment &environment,
+                         int procsDescriptor, const StopSignal *stop) -> bool {
+	if (socket == -1 && ! start())
+		return false;
+
+	stopSignal = stop;
+
+	// See serve() in unix/watcher_unix.cpp
+	QStringList fields;
+	const QStringList variables = (environment.inheritsFromParent() ? QProcessEnvironment::systemEnvironment()
+	                                                                : environment)
+	                                  .toStringList();
+	fields << getWorkingDirectory() << QString::number(arguments.size()) << arguments;
+	fields << QString::number(variables.size()) << variables;
+	fields << QString::number(procsDescriptor == -1 ? -1 : 0);
+
+	QByteArray packet;
+
+	for (const auto &field : std::as_const(fields))
+		packet.append(encode(field)).append('\0');
+
+	auto sendPacket = [&] {
+		iovec iov{packet.data(), static_cast<size_t>(packet.size())};
+		char control[CMSG_SPACE(sizeof(int))] = {};
+		msghdr message{};
+		message.msg_iov = &iov;
+		message.msg_iovlen = 1;
+
+		if (procsDescriptor != -1) {
+			message.msg_control = control;
+			message.msg_controllen = sizeof(control);
+			cmsghdr *header = CMSG_FIRSTHDR(&message);
+			header->cmsg_level = SOL_SOCKET;
+			header->cmsg_type = SCM_RIGHTS;
+			header->cmsg_len = CMSG_LEN(sizeof(int));
+			memcpy(CMSG_DATA(header), &procsDescriptor, sizeof(int));
+		}
+
+		return ::sendmsg(socket, &message, MSG_NOSIGNAL) == packet.size();
+	};
+
+	if (sendPacket())
+		return true;
+
+	// The sandbox went away since the last test case, try a new one
+	kill();
+
+	if (start() && sendPacket())
+		return true;
+
+	kill();
+	return false;
+}
+
+auto SandboxZygote::waitForFinished(int msecs) -> ProcessLauncher::WaitResult {
+	QDeadlineTimer deadline(msecs);
+	pollfd fds[2] = {{socket, POLLIN, 0}, {stopSignal ? stopSignal->getDescriptor() : -1, POLLIN, 0}};
+
+	while (true) {
+		if (stopSignal && stopSignal->isRaised())
+			return ProcessLauncher::Stopped;
+
+		int timeout = deadline.isForever() ? -1 : static_cast<int>(deadline.remainingTime());
+
+		// Without an eventfd the stop request has to be polled for
+		if (stopSignal && fds[1].fd == -1)
+			timeout = timeout < 0 ? 10 : qMin(timeout, 10);
+
+		if (::poll(fds, 2, timeout) > 0 && fds[0].revents != 0) {
+			if (! receive()) {
+				code = 1;
+				timeUsed = -1;
+				memoryUsed = -1;
+				message = "The sandbox exited unexpectedly";
+				kill();
+			}
+
+			return ProcessLauncher::Finished;
+		}
+
+		if (stopSignal && stopSignal->isRaised())
+			return ProcessLauncher::Stopped;
+
+		if (deadline.hasExpired())
+			return ProcessLauncher::TimedOut;
+	}
+}
+
+// "code time memory\n" followed by the message
+auto SandboxZygote::receive() -> bool {
+	QByteArray reply(1 << 17, Qt::Uninitialized);
+	ssize_t length = ::recv(socket, reply.data(), reply.size(), 0);
+
+	if (length <= 0)
+		return false;
+
+	reply.truncate(length);
+
+	int end = reply.indexOf('\n');
+	const QList<QByteArray> header = reply.left(end).split(' ');
+
+	if (end < 0 || header.size() != 3)
+		return false;
+
+	code = header[0].toInt();
+	timeUsed = header[1].toInt();
+	memoryUsed = header[2].toLongLong();
+	message = QString::fromLocal8Bit(reply.mid(end + 1));
+	return true;
+}
+
+auto SandboxZygote::exitCode() const -> int { return code; }
+
+auto SandboxZygote::getTimeUsed() const -> int { return timeUsed; }
+
+auto SandboxZygote::getMemoryUsed() const -> qint64 { return memoryUsed; }
+
+auto SandboxZygote::getMessage() const -> QString { return message; }
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#ifdef Q_OS_LINUX
+
+#include "processlauncher.h"
+
+#include <QProcessEnvironment>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <memory>
+
+struct ProcessRunnerConfig;
+
+// A bwrap sandbox kept running for one judging slot, with `watcher --zygote`
+// inside: setting up the namespaces is paid once per slot, each test case
+// then costs one fork and exec of the program, and comes back as a result
+// record instead of text to parse.
+//
+// The sandbox sees a private slot directory, read-write except its "ro"
+// subdirectory. enter() moves the working directory of a test case in there
+// (a rename on the same filesystem) and provides the input file and the
+// shared read-only files in "ro"; leave() puts everything back. Between two
+// test cases the zygote kills whatever the program left running and empties
+// /tmp and /dev/shm.
+//
+// The JudgingWorker creates one when it starts. Test cases that do not fit,
+// e.g. because the input file is large and cannot be hard-linked, fall back
+// to a sandbox of their own.
+class SandboxZygote {
+  public:
+	SandboxZygote();
+	~SandboxZygote();
+	SandboxZygote(const SandboxZygote &) = delete;
+	SandboxZygote &operator=(const SandboxZygote &) = delete;
+
+	// The zygote of the calling thread, nullptr if it has none
+	static SandboxZygote *current();
+
+	// False if the test case cannot use the zygote, nothing is changed then
+	bool enter(const ProcessRunnerConfig &);
+	void leave();
+	// Where the sandbox shows the working directory and the input file
+	QString getWorkingDirectory() const;
+	QString getInputFile() const;
+
+	// Start the watcher with `arguments`, restarting the sandbox if needed
+	bool send(const QStringList &arguments, const QProcessEnvironment &, int procsDescriptor,
+	          const StopSignal *);
+	ProcessLauncher::WaitResult waitForFinished(int msecs);
+	// Tear the sandbox down with everything in it, the next send() starts a new one
+	void kill();
+
+	// The result of the watcher, once finished
+	int exitCode() const;
+	int getTimeUsed() const;
+	qint64 getMemoryUsed() const;
+	QString getMessage() const;
+
+  private:
+	QTemporaryDir slotDir;
+	std::unique_ptr<ProcessLauncher> sandbox;
+	int socket{-1};
+	const StopSignal *stopSignal{};
+
+	// The test case between enter() and leave()
+	QString workingDirectory;
+	QStringList movedFiles;
+	QString inputLink;
+
+	int code{};
+	int timeUsed{-1};
+	qint64 memoryUsed{-1};
+	QString message;
+
+	bool start();
+	bool receive();
+};
+
+#endif
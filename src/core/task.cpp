@@ -41,6 +41,12 @@ auto Task::getStandardInputCheck() const -> bool { return standardInputCheck; }
 
 auto Task::getStandardOutputCheck() const -> bool { return standardOutputCheck; }
 
+auto Task::getStopOnFirstZero() const -> bool { return stopOnFirstZero; }
+
+auto Task::getCheckWhileRunning() const -> bool { return checkWhileRunning; }
+
+auto Task::getCacheVerdicts() const -> bool { return cacheVerdicts; }
+
 auto Task::getTaskType() const -> Task::TaskType { return taskType; }
 
 auto Task::getComparisonMode() const -> Task::ComparisonMode { return comparisonMode; }
@@ -55,6 +61,8 @@ auto Task::getInteractor() const -> const QString & { return interactor; }
 
 auto Task::getInteractorName() const -> const QString & { return interactorName; }
 
+auto Task::getRunInteractor() const -> bool { return runInteractor; }
+
 auto Task::getGrader() const -> const QString & { return grader; }
 
 auto Task::getCompilerConfiguration(const QString &compilerName) const -> QString {
@@ -91,6 +99,12 @@ void Task::setStandardInputCheck(bool check) { standardInputCheck = check; }
 
 void Task::setStandardOutputCheck(bool check) { standardOutputCheck = check; }
 
+void Task::setStopOnFirstZero(bool check) { stopOnFirstZero = check; }
+
+void Task::setCheckWhileRunning(bool check) { checkWhileRunning = check; }
+
+void Task::setCacheVerdicts(bool check) { cacheVerdicts = check; }
+
 void Task::setTaskType(Task::TaskType type) { taskType = type; }
 
 void Task::setComparisonMode(Task::ComparisonMode mode) { comparisonMode = mode; }
@@ -105,6 +119,8 @@ void Task::setInteractor(const QString &fileName) { interactor = fileName; }
 
 void Task::setInteractorName(const QString &fileName) { interactorName = fileName; }
 
+void Task::setRunInteractor(bool check) { runInteractor = check; }
+
 void Task::setGrader(const QString &fileName) { grader = fileName; }
 
 void Task::setCompilerConfiguration(const QString &compiler, const QString &configuration) {
@@ -247,6 +263,9 @@ int Task::writeToJson(QJsonObject &in) {
 	WRITE_JSON(in, standardOutputCheck);
 	WRITE_JSON(in, taskType);
 	WRITE_JSON(in, subFolderCheck);
+	WRITE_JSON(in, stopOnFirstZero);
+	WRITE_JSON(in, checkWhileRunning);
+	WRITE_JSON(in, cacheVerdicts);
 	WRITE_JSON(in, comparisonMode);
 	WRITE_JSON(in, diffArguments);
 	WRITE_JSON(in, realPrecision);
@@ -261,6 +280,7 @@ int Task::writeToJson(QJsonObject &in) {
 		grader.replace(QDir::separator(), '/');
 		WRITE_JSON(in, grader);
 		WRITE_JSON(in, interactorName);
+		WRITE_JSON(in, runInteractor);
 	}
 
 	if (taskType == Task::Communication || taskType == Task::CommunicationExec) {
@@ -318,6 +338,9 @@ int Task::readFromJson(const QJsonObject &in) {
 	READ_JSON(in, taskType);
 	this->taskType = static_cast<TaskType>(taskType);
 	READ_JSON(in, subFolderCheck);
+	READ_JSON(in, stopOnFirstZero);
+	READ_JSON(in, checkWhileRunning);
+	READ_JSON(in, cacheVerdicts);
 	int comparisonMode;
 	READ_JSON(in, comparisonMode);
 	this->comparisonMode = static_cast<ComparisonMode>(comparisonMode);
@@ -331,6 +354,7 @@ int Task::readFromJson(const QJsonObject &in) {
 		READ_JSON(in, grader);
 		grader.replace('/', QDir::separator());
 		READ_JSON(in, interactorName);
+		READ_JSON(in, runInteractor);
 	}
 
 	if (taskType == Task::Communication || taskType == Task::CommunicationExec) {
@@ -26,7 +26,10 @@ class Task : public QObject {
 		ExternalToolMode,
 		RealNumberMode,
 		LemonSpecialJudgeMode,
-		TestlibSpecialJudgeMode
+		TestlibSpecialJudgeMode,
+		BinaryMode,
+		CheckerPluginMode,
+		BatchSpecialJudgeMode
 	};
 
 	explicit Task(QObject *parent = nullptr, TaskType taskType = Traditional,
@@ -43,6 +46,9 @@ class Task : public QObject {
 	const QString &getOutputFileName() const;
 	bool getStandardInputCheck() const;
 	bool getStandardOutputCheck() const;
+	bool getStopOnFirstZero() const;
+	bool getCheckWhileRunning() const;
+	bool getCacheVerdicts() const;
 	TaskType getTaskType() const;
 	ComparisonMode getComparisonMode() const;
 	const QString &getDiffArguments() const;
@@ -50,6 +56,7 @@ class Task : public QObject {
 	const QString &getSpecialJudge() const;
 	const QString &getInteractor() const;
 	const QString &getInteractorName() const;
+	bool getRunInteractor() const;
 	const QString &getGrader() const;
 	QString getCompilerConfiguration(const QString &) const;
 	const QString &getAnswerFileExtension() const;
@@ -65,6 +72,9 @@ class Task : public QObject {
 	void setOutputFileName(const QString &);
 	void setStandardInputCheck(bool);
 	void setStandardOutputCheck(bool);
+	void setStopOnFirstZero(bool);
+	void setCheckWhileRunning(bool);
+	void setCacheVerdicts(bool);
 	void setTaskType(TaskType);
 	void setComparisonMode(ComparisonMode);
 	void setDiffArguments(const QString &);
@@ -72,6 +82,7 @@ class Task : public QObject {
 	void setSpecialJudge(const QString &);
 	void setInteractor(const QString &);
 	void setInteractorName(const QString &);
+	void setRunInteractor(bool);
 	void setGrader(const QString &);
 	void setCompilerConfiguration(const QString &, const QString &);
 	void setAnswerFileExtension(const QString &);
@@ -112,9 +123,14 @@ class Task : public QObject {
 	bool standardInputCheck;
 	bool standardOutputCheck;
 	bool subFolderCheck;
+	bool stopOnFirstZero = false;
+	bool checkWhileRunning = false;
+	bool cacheVerdicts = false;
 	QString specialJudge;
 	QString interactor;
 	QString interactorName;
+	// The interactor is a program talking to the contestant's, not a header
+	bool runInteractor = false;
 	QString grader;
 	QStringList sourceFilesPath;
 	QStringList sourceFilesName;
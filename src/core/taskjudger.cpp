@@ -9,18 +9,28 @@
 #include "base/LemonType.hpp"
 #include "base/compiler.h"
 #include "base/settings.h"
+#include "core/buildcache.h"
+#include "core/compilecache.h"
+#include "core/compilerprofiles.h"
 #include "core/contestant.h"
+#include "core/fileprovisioner.h"
+#include "core/judgingpool.h"
 #include "core/judgingthread.h"
+#include "core/processlauncher.h"
+#include "core/processrunner.h"
 #include "core/subtaskdependencelib.h"
 #include "core/task.h"
 #include "core/testcase.h"
 
+#include <QRegularExpression>
 #include <QSysInfo>
 #include <QTimer>
 #include <QtMath>
 
 #include <algorithm>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #define LEMON_MODULE_NAME "TaskJudger"
 
@@ -34,8 +44,354 @@ void TaskJudger::setTaskId(int id) { taskId = id; }
 
 void TaskJudger::setContestant(Contestant *contestant) { this->contestant = contestant; }
 
+void TaskJudger::setJudgingPool(JudgingPool *_pool) { pool = _pool; }
+
+void TaskJudger::setCheckPool(JudgingPool *_pool) { checkPool = _pool; }
+
+void TaskJudger::setCompilePool(JudgingPool *_pool) { compilePool = _pool; }
+
+void TaskJudger::setAnswerCache(AnswerCache *cache) { answerCache = cache; }
+
+void TaskJudger::setVerdictCache(VerdictCache *cache) { verdictCache = cache; }
+
+void TaskJudger::setCheckerPlugins(CheckerPlugins *plugins) { checkerPlugins = plugins; }
+
+void TaskJudger::setBuildCache(BuildCache *cache) { buildCache = cache; }
+
+void TaskJudger::setCompileCache(CompileCache *cache) { compileCache = cache; }
+
+void TaskJudger::setCompilerProfiles(const CompilerProfiles *profiles) { compilerProfiles = profiles; }
+
 Contestant *TaskJudger::getContestant() const { return contestant; }
 
+namespace {
+	// The names in `entries` matched by one of `filters`, as QDir::entryList()
+	// would have listed them
+	auto matchFiles(const QStringList &entries, const QStringList &filters) -> QStringList {
+		QList<QRegularExpression> patterns;
+
+		for (const auto &filter : filters)
+			patterns.append(QRegularExpression(QRegularExpression::wildcardToRegularExpression(filter),
+			                                   QRegularExpression::CaseInsensitiveOption));
+
+		QStringList files;
+
+		for (const auto &entry : entries) {
+			auto matches = [&entry](const QRegularExpression &pattern) {
+				return pattern.match(entry).hasMatch();
+			};
+
+			if (std::any_of(patterns.begin(), patterns.end(), matches))
+				files.append(entry);
+		}
+
+		return files;
+	}
+
+	// The compiler command for `source`, named `output` once built
+	auto compileCommand(QString arguments, const QString &source, const QString &output) -> QStringList {
+		arguments.replace("%s.*", source);
+		arguments.replace("%s", output);
+		return arguments.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+	}
+
+	auto executableName(const QString &name) -> QString {
+#ifdef Q_OS_WIN32
+		return name + ".exe";
+#else
+		return name;
+#endif
+	}
+} // namespace
+
+// Compile the graders of an interaction or communication task into object
+// files once for the session, and put them next to the contestant's sources.
+// Returns the objects in place of the grader sources, nothing if they cannot
+// be prebuilt and have to be compiled along with the contestant's code.
+auto TaskJudger::prebuildGraders(const CompilerProfile &profile, const QString &arguments,
+                                 const QList<QPair<QString, QString>> &files, const QStringList &sources,
+                                 const QString &targetDirectory) -> QStringList {
+	if (! buildCache || profile.compiler->getCompilerType() != Compiler::Typical)
+		return {};
+
+	BuildCache::Job job;
+	job.files = files;
+	job.compiler = profile.compiler->getCompilerLocation();
+	job.environment = profile.environment;
+
+	for (const auto &source : sources) {
+		job.commands.append(QStringList("-c") + compileCommand(arguments, source, source + ".o"));
+		job.outputs.append(source + ".o");
+	}
+
+	return installBuild(job, targetDirectory) ? job.outputs : QStringList();
+}
+
+// Build a program that needs nothing from the contestant, such as the grader
+// of a communication task, into `targetDirectory`
+auto TaskJudger::prebuildProgram(const CompilerProfile &profile, const QString &arguments,
+                                 const QList<QPair<QString, QString>> &files, const QString &source,
+                                 const QString &name, const QString &targetDirectory) -> bool {
+	if (! buildCache || profile.compiler->getCompilerType() != Compiler::Typical)
+		return false;
+
+	BuildCache::Job job;
+	job.files = files;
+	job.compiler = profile.compiler->getCompilerLocation();
+	job.environment = profile.environment;
+	job.commands.append(compileCommand(arguments, source, name));
+	job.outputs.append(executableName(name));
+	return installBuild(job, targetDirectory);
+}
+
+// Build `job` with the session's cache and copy its outputs to
+// `targetDirectory`
+auto TaskJudger::installBuild(const BuildCache::Job &job, const QString &targetDirectory) -> bool {
+	auto build = buildCache->build(job, settings->getCompileTimeLimit(), &stopSignal);
+
+	if (! build.succeeded) {
+		if (! build.message.isEmpty())
+			WARN("Cannot prebuild", job.outputs.join(' '), build.message);
+
+		return false;
+	}
+
+	for (const auto &output : job.outputs)
+		if (! QFile::copy(build.directory + QDir::separator() + output,
+		                  targetDirectory + QDir::separator() + output))
+			return false;
+
+	return true;
+}
+
+// The arguments that point the compiler at the precompiled header of
+// `profile`, built with `arguments` once for the session, if a source in
+// `directory` includes it. The compiler takes the header from its usual place
+// if the precompiled one does not suit, so the program is the same either way.
+auto TaskJudger::precompiledHeader(const CompilerProfile &profile, const QString &arguments,
+                                   const QString &directory) -> QString {
+	const auto *compiler = profile.compiler;
+	const QString header = compiler->getPrecompiledHeader();
+
+	if (! buildCache || header.isEmpty() || compiler->getCompilerType() != Compiler::Typical)
+		return {};
+
+	const QRegularExpression include(
+	    QString(R"(^\s*#\s*include\s*[<"]%1[>"])").arg(QRegularExpression::escape(header)),
+	    QRegularExpression::MultilineOption);
+	QStringList filters = compiler->getSourceExtensions();
+
+	for (auto &k : filters)
+		k = "*." + k;
+
+	const QStringList sources = QDir(directory).entryList(filters, QDir::Files);
+	const bool included = std::any_of(sources.begin(), sources.end(), [&](const QString &name) {
+		QFile source(directory + QDir::separator() + name);
+		return source.open(QFile::ReadOnly) &&
+		       include.match(QString::fromLocal8Bit(source.readAll())).hasMatch();
+	});
+
+	if (! included)
+		return {};
+
+	// Includes the header from wherever the compiler finds it
+	const QString stub = "lemon-pch.h";
+	QFile file(temporaryDir.filePath(stub));
+
+	if (! file.open(QFile::WriteOnly) || file.write(QString("#include <%1>\n").arg(header).toUtf8()) == -1)
+		return {};
+
+	file.close();
+
+	BuildCache::Job job;
+	job.files.append(qMakePair(file.fileName(), stub));
+	job.compiler = compiler->getCompilerLocation();
+	job.environment = profile.environment;
+	job.commands.append(QStringList("-c") + compileCommand(arguments, stub, header + ".gch"));
+	job.outputs.append(header + ".gch");
+
+	auto build = buildCache->build(job, settings->getCompileTimeLimit(), &stopSignal);
+
+	if (! build.succeeded) {
+		if (! build.message.isEmpty())
+			WARN("Cannot precompile", header, build.message);
+
+		return {};
+	}
+
+	// Split on spaces along with the other arguments
+	if (build.directory.contains(' '))
+		return {};
+
+	return " -I" + QDir::toNativeSeparators(build.directory);
+}
+
+// The special judge to run, built first if the task points at its source
+auto TaskJudger::specialJudgeProgram() -> QString {
+	const QString source = Settings::dataPath() + task->getSpecialJudge();
+	const auto mode = task->getComparisonMode();
+
+	if (mode != Task::LemonSpecialJudgeMode && mode != Task::TestlibSpecialJudgeMode &&
+	    mode != Task::BatchSpecialJudgeMode)
+		return source;
+
+	return taskProgram(source, "checker");
+}
+
+// A program given by the task, built as `name` with the session's cache if
+// `source` is the source of one. Headers beside it are taken along for the
+// likes of testlib.h.
+auto TaskJudger::taskProgram(const QString &source, const QString &name) -> QString {
+	if (! buildCache)
+		return source;
+
+	QFileInfo info(source);
+
+	for (const auto *profile : compilerProfiles->forExtension(info.suffix())) {
+		const auto *compiler = profile->compiler;
+
+		if (compiler->getCompilerType() != Compiler::Typical)
+			continue;
+
+		const int index =
+		    profile->findConfiguration(task->getCompilerConfiguration(compiler->getCompilerName()));
+		const QString output = executableName(name);
+
+		BuildCache::Job job;
+		job.files.append(qMakePair(source, info.fileName()));
+		job.compiler = compiler->getCompilerLocation();
+		job.environment = profile->environment;
+		job.commands.append(
+		    compileCommand(compiler->getCompilerArguments().value(index), info.fileName(), name));
+		job.outputs.append(output);
+
+		const QStringList headers = info.dir().entryList({"*.h", "*.hpp", "*.hh", "*.hxx"}, QDir::Files);
+
+		for (const auto &header : headers)
+			job.files.append(qMakePair(info.dir().filePath(header), header));
+
+		auto build = buildCache->build(job, settings->getCompileTimeLimit(), &stopSignal);
+
+		if (! build.succeeded) {
+			WARN("Cannot build", source, build.message);
+			return source;
+		}
+
+		return build.directory + QDir::separator() + output;
+	}
+
+	return source;
+}
+
+// Run the compiler in `directory` once for each of `arguments`, which sets
+// compileState. The runs are independent units, such as the programs of a
+// communication task, made side by side with as many at once as the compile
+// pool has threads; the first to fail cancels the others, and the messages are
+// headed by the names in `units`. False if judging is stopped meanwhile.
+auto TaskJudger::runCompiler(const Compiler *compiler, const QStringList &arguments,
+                             const QString &directory, const QStringList &units) -> bool {
+	struct Unit {
+		bool done{};
+		CompileState state{CompileSuccessfully};
+		QString message;
+	};
+
+	std::vector<Unit> results(arguments.size());
+	std::atomic<int> next{0};
+
+	auto work = [&] {
+		for (int k = next++; k < arguments.size() && ! compileStop.isRaised(); k = next++) {
+			ProcessLauncher compilerProcess(&compileStop);
+			compilerProcess.setMergedChannels(true);
+			compilerProcess.setProcessEnvironment(environment);
+			compilerProcess.setWorkingDirectory(directory);
+			// TODO: 需要重构代码来处理含空格路径问题
+
+			compilerProcess.setProgram(compiler->getCompilerLocation(),
+			                           arguments[k].split(QLatin1Char(' '), Qt::SkipEmptyParts));
+
+			if (! compilerProcess.start()) {
+				results[k] = {true, InvalidCompiler, {}};
+				compileStop.raise();
+				continue;
+			}
+
+			ProcessLauncher::WaitResult status =
+			    compilerProcess.waitForFinished(settings->getCompileTimeLimit());
+
+			// Stopped, or cancelled by another unit
+			if (status == ProcessLauncher::Stopped) {
+				compilerProcess.kill();
+				continue;
+			}
+
+			if (status == ProcessLauncher::TimedOut) {
+				compilerProcess.kill();
+				results[k] = {true, CompileTimeLimitExceeded, {}};
+			} else if (compilerProcess.exitCode() != 0) {
+				results[k] = {true, CompileError,
+				              QString::fromLocal8Bit(compilerProcess.readAllStandardOutput().constData())};
+			} else {
+				results[k].done = true;
+			}
+
+			if (results[k].state != CompileSuccessfully)
+				compileStop.raise();
+		}
+	};
+
+	const int threadCount =
+	    qMin(static_cast<int>(arguments.size()), compilePool ? compilePool->getWorkerCount() : 1);
+	std::vector<std::thread> helpers;
+
+	for (int k = 1; k < threadCount; k++)
+		helpers.emplace_back(work);
+
+	work();
+
+	for (auto &helper : helpers)
+		helper.join();
+
+	if (stopSignal.isRaised())
+		return false;
+
+	// In the order of the units, those cancelled have nothing to tell
+	QStringList messages;
+	compileState = CompileSuccessfully;
+
+	for (int k = 0; k < arguments.size(); k++) {
+		if (! results[k].done || results[k].state == CompileSuccessfully)
+			continue;
+
+		if (compileState == CompileSuccessfully)
+			compileState = results[k].state;
+
+		if (! results[k].message.isEmpty())
+			messages.append(k < units.size() ? units[k] + ":\n" + results[k].message : results[k].message);
+	}
+
+	if (compileState != CompileSuccessfully) {
+		compileMessage = messages.join('\n');
+		return true;
+	}
+
+	if (compiler->getCompilerType() == Compiler::Typical) {
+		if (! QDir(directory).exists(executableFile))
+			compileState = InvalidCompiler;
+	} else {
+		QStringList filters = compiler->getBytecodeExtensions();
+
+		for (int k = 0; k < filters.size(); k++) {
+			filters[k] = QString("*.") + filters[k];
+		}
+
+		if (QDir(directory).entryList(filters, QDir::Files).empty())
+			compileState = InvalidCompiler;
+	}
+
+	return true;
+}
+
 // Get executable file
 auto TaskJudger::traditionalTaskPrepare() -> bool {
 	makeDialogAlert(tr("Preparing..."));
@@ -49,9 +405,11 @@ auto TaskJudger::traditionalTaskPrepare() -> bool {
 	        ? QDir(Settings::sourcePath() + contestantName)
 	        : QDir(Settings::sourcePath() + contestantName + QDir::separator() + task->getSourceFileName());
 	QString contestantDirName = contestantDir.path();
-	QList<Compiler *> compilerList = settings->getCompilerList();
+	const QStringList entries = contestantDir.entryList(QDir::Files);
+
+	for (const auto &profile : compilerProfiles->getProfiles()) {
+		const auto *i = profile.compiler;
 
-	for (auto &i : compilerList) {
 		if (task->getCompilerConfiguration(i->getCompilerName()) == "disable")
 			continue;
 
@@ -67,7 +425,7 @@ auto TaskJudger::traditionalTaskPrepare() -> bool {
 			}
 		}
 
-		QStringList files = contestantDir.entryList(filters, QDir::Files);
+		QStringList files = matchFiles(entries, filters);
 		sourceFile = "";
 
 		for (int j = 0; j < files.size(); j++) {
@@ -113,8 +471,10 @@ auto TaskJudger::traditionalTaskPrepare() -> bool {
 		}
 
 		QString extraFiles = "";
+		// Unless the interactor runs on its own, it is compiled in
+		const bool linksInteractor = task->getTaskType() == Task::Interaction && ! task->getRunInteractor();
 
-		if (task->getTaskType() == Task::Interaction) {
+		if (linksInteractor) {
 			QFile::copy(Settings::dataPath() + task->getInteractor(),
 			            QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator() + contestantName +
 			                QDir::separator() + task->getInteractorName());
@@ -136,41 +496,17 @@ auto TaskJudger::traditionalTaskPrepare() -> bool {
 		}
 
 		// Get compiler configuration
-		QStringList configurationNames = i->getConfigurationNames();
 		QStringList compilerArguments = i->getCompilerArguments();
 		QStringList interpreterArguments = i->getInterpreterArguments();
-		QString currentConfiguration = task->getCompilerConfiguration(i->getCompilerName());
-
 		int configurationIndex =
-		    std::find(configurationNames.begin(), configurationNames.end(), currentConfiguration) -
-		    configurationNames.begin();
+		    profile.findConfiguration(task->getCompilerConfiguration(i->getCompilerName()));
 
 		compilerTimeLimitRatio = i->getTimeLimitRatio();
 		compilerMemoryLimitRatio = i->getMemoryLimitRatio();
 		disableMemoryLimitCheck = i->getDisableMemoryLimitCheck();
 		interpreterAsWatcher = i->getInterpreterAsWatcher();
-		environment = i->getEnvironment();
-		QStringList values = QProcessEnvironment::systemEnvironment().toStringList();
-
-		for (int k = 0; k < values.size(); k++) {
-			int tmp = values[k].indexOf("=");
-
-			if (tmp == 0)
-				continue;
-
-			QString variable = values[k].mid(0, tmp);
-			if (environment.contains(variable))
-				// ';' for windows ':' for linux
-				environment.insert(variable, environment.value(variable) +
-#ifdef Q_OS_WIN32
-				                                 ";"
-#else
-				                                 ":"
-#endif
-				                                 + QProcessEnvironment::systemEnvironment().value(variable));
-			else
-				environment.insert(variable, QProcessEnvironment::systemEnvironment().value(variable));
-		}
+		runInShell = i->getRunInShell();
+		environment = profile.environment;
 
 		if (i->getCompilerType() == Compiler::Typical) {
 			if (task->getTaskType() == Task::CommunicationExec)
@@ -189,14 +525,52 @@ auto TaskJudger::traditionalTaskPrepare() -> bool {
 			interpreterFlag = true;
 		}
 
+		const QString contestantDirectory =
+		    QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator() + contestantName;
+		QString interactionGrader = "__grader.cpp";
+
+		if (linksInteractor) {
+			QStringList objects = prebuildGraders(
+			    profile, compilerArguments[configurationIndex],
+			    {qMakePair(Settings::dataPath() + task->getInteractor(), task->getInteractorName()),
+			     qMakePair(Settings::dataPath() + task->getGrader(), interactionGrader)},
+			    {interactionGrader}, contestantDirectory);
+
+			if (! objects.isEmpty())
+				interactionGrader = objects.constFirst();
+		}
+
+		if (task->getTaskType() == Task::Communication) {
+			QList<QPair<QString, QString>> files;
+			QStringList sources;
+			QString otherFiles;
+
+			for (int k = 0; k < graderPaths.length(); k++) {
+				files.append(qMakePair(Settings::dataPath() + graderPaths[k], graderNames[k]));
+
+				if (i->getSourceExtensions().contains(QFileInfo(graderNames[k]).suffix()))
+					sources.append(graderNames[k]);
+				else
+					otherFiles = otherFiles + " " + graderNames[k] + " ";
+			}
+
+			QStringList objects = prebuildGraders(profile, compilerArguments[configurationIndex], files,
+			                                      sources, contestantDirectory);
+
+			if (! objects.isEmpty())
+				extraFiles = otherFiles + " " + objects.join(' ') + " ";
+		}
+
 		if (i->getCompilerType() != Compiler::InterpretiveWithoutByteCode) {
 			makeDialogAlert(tr("Compiling..."));
 
 			QStringList arguments;
 			arguments.append(compilerArguments[configurationIndex]);
+			// Names of the units in `arguments`, if there are several
+			QStringList units;
 
-			if (task->getTaskType() == Task::Interaction) {
-				arguments[0].replace("%s.*", sourceFile + " __grader.cpp");
+			if (linksInteractor) {
+				arguments[0].replace("%s.*", sourceFile + " " + interactionGrader);
 				arguments[0].replace("%s", task->getSourceFileName());
 			} else if (task->getTaskType() == Task::Communication) {
 				arguments[0].replace("%s.*", sourceFile + extraFiles);
@@ -211,6 +585,8 @@ auto TaskJudger::traditionalTaskPrepare() -> bool {
 					arguments[k].replace("%s", name);
 				}
 
+				units = sourceNames;
+
 				QStringList filters = i->getSourceExtensions();
 				for (auto &k : filters)
 					k = commExecGrader + "." + k;
@@ -231,82 +607,49 @@ auto TaskJudger::traditionalTaskPrepare() -> bool {
 				}
 				// Why? It's unix Only
 				auto graderArgument = compilerArguments[configurationIndex] + " -pthread";
-				arguments.append(graderArgument);
-				graderArgument.replace("%s.*", mainGraderName);
-				graderArgument.replace("%s", commExecGrader);
-				arguments.append(graderArgument);
+				QList<QPair<QString, QString>> files;
+
+				for (int k = 0; k < graderPaths.length(); k++)
+					files.append(qMakePair(Settings::dataPath() + graderPaths[k], graderNames[k]));
+
+				// The same for every contestant, built once for the session
+				if (! prebuildProgram(profile, graderArgument, files, mainGraderName, commExecGrader,
+				                      contestantDirectory)) {
+					graderArgument.replace("%s.*", mainGraderName);
+					graderArgument.replace("%s", commExecGrader);
+					arguments.append(graderArgument);
+					units.append(mainGraderName);
+				}
 			} else {
 				arguments[0].replace("%s.*", sourceFile);
 				arguments[0].replace("%s", task->getSourceFileName());
 			}
 
-			for (auto k : arguments) {
-				QProcess compilerProcess;
-				compilerProcess.setProcessChannelMode(QProcess::MergedChannels);
-				compilerProcess.setProcessEnvironment(environment);
-				compilerProcess.setWorkingDirectory(QDir::toNativeSeparators(temporaryDir.path()) +
-				                                    QDir::separator() + contestantName);
-				// TODO: 需要重构代码来处理含空格路径问题
+			CompileCache::Job job;
+			job.directory = contestantDirectory;
+			job.compiler = i->getCompilerLocation();
+			job.environment = environment;
+			job.commands = arguments;
 
-				compilerProcess.start(i->getCompilerLocation(),
-				                      k.split(QLatin1Char(' '), Qt::SkipEmptyParts));
+			// Everything in the directory before compiling goes into the key
+			const QStringList inputs = QDir(contestantDirectory).entryList(QDir::Files | QDir::Hidden);
+			const QByteArray compileKey = compileCache ? compileCache->key(job) : QByteArray();
 
-				if (! compilerProcess.waitForStarted(-1)) {
-					compileState = InvalidCompiler;
-					break;
-				}
-
-				QElapsedTimer timer;
-				timer.start();
-				bool flag = false;
-
-				while (timer.elapsed() < settings->getCompileTimeLimit()) {
-					if (compilerProcess.waitForFinished(10)) {
-						flag = true;
-						break;
-					}
+			if (compileKey.isEmpty() ||
+			    ! compileCache->restore(compileKey, contestantDirectory, compileState, compileMessage)) {
+				// Left out of the key, as it changes nothing but how long it takes
+				const QString header =
+				    precompiledHeader(profile, compilerArguments[configurationIndex], contestantDirectory);
 
-					QCoreApplication::processEvents();
+				for (auto &k : arguments)
+					k += header;
 
-					if (! isJudging) {
-						compilerProcess.kill();
-						return false;
-					}
-				}
+				if (! runCompiler(i, arguments, contestantDirectory, units))
+					return false;
 
-				if (! flag) {
-					compilerProcess.kill();
-					compileState = CompileTimeLimitExceeded;
-				} else if (compilerProcess.exitCode() != 0) {
-					compileState = CompileError;
-					compileMessage =
-					    QString::fromLocal8Bit(compilerProcess.readAllStandardOutput().constData());
-				} else {
-					if (i->getCompilerType() == Compiler::Typical) {
-						if (! QDir(QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator() +
-						           contestantName)
-						          .exists(executableFile)) {
-							compileState = InvalidCompiler;
-						} else {
-							compileState = CompileSuccessfully;
-						}
-					} else {
-						QStringList filters = i->getBytecodeExtensions();
-
-						for (int k = 0; k < filters.size(); k++) {
-							filters[k] = QString("*.") + filters[k];
-						}
-
-						if (QDir(QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator() +
-						         contestantName)
-						        .entryList(filters, QDir::Files)
-						        .empty()) {
-							compileState = InvalidCompiler;
-						} else {
-							compileState = CompileSuccessfully;
-						}
-					}
-				}
+				if (! compileKey.isEmpty())
+					compileCache->store(compileKey, contestantDirectory, inputs, compileState,
+					                    compileMessage);
 			}
 
 			makeDialogAlert(tr("Compiled Successfully"));
@@ -327,35 +670,92 @@ auto TaskJudger::traditionalTaskPrepare() -> bool {
 	return true;
 }
 
-void TaskJudger::judgeIt() {
+void TaskJudger::compileIt() {
 	qDebug() << "Start Judging";
+	isJudging = true;
 	emit judgingStarted(task->getProblemTitle());
-	if (judge()) {
-		contestant->setCheckJudged(taskId, true);
-		contestant->setCompileMessage(taskId, compileMessage);
-		contestant->setCompileState(taskId, compileState);
-		contestant->setResult(taskId, result);
-		contestant->setMessage(taskId, message);
-		contestant->setTimeUsed(taskId, timeUsed);
-		contestant->setMemoryUsed(taskId, memoryUsed);
-		contestant->setScore(taskId, score);
-		contestant->setInputFiles(taskId, inputFiles);
-		contestant->setSourceFile(taskId, sourceFile);
-	} else {
-		contestant->setCheckJudged(taskId, false);
+	compilePool->submit(compilePool->nextQueue(), [this] {
+		if (compile()) {
+			emit compiled();
+			return;
+		}
+
+		{
+			QMutexLocker locker(&mutex);
+			finished = true;
+		}
+
+		// As in jobFinished(), this may be deleted from now on
+		finish();
+	});
+}
+
+void TaskJudger::judgeIt() {
+	poolQueue = pool->nextQueue();
+	checkQueue = checkPool ? checkPool->nextQueue() : 0;
+	QMutexLocker locker(&mutex);
+	submit([this] { prepare(); });
+}
+
+// Must be called with `mutex` held.
+void TaskJudger::submit(std::function<void()> job) {
+	outstandingJobs++;
+	pool->submit(poolQueue, [this, job = std::move(job)] {
+		job();
+		jobFinished();
+	});
+}
+
+// Must be called with `mutex` held.
+void TaskJudger::submitCheck(std::function<void()> job) {
+	outstandingJobs++;
+	checkPool->submit(checkQueue, [this, job = std::move(job)] {
+		job();
+		jobFinished();
+	});
+}
+
+void TaskJudger::jobFinished() {
+	{
+		QMutexLocker locker(&mutex);
+
+		if (--outstandingJobs > 0 || finished)
+			return;
+
+		finished = true;
 	}
-	emit judgingFinished();
+
+	// The controller deletes this TaskJudger once judgingFinished is
+	// delivered, so nothing may touch it after finish().
+	finish();
 }
 
-int TaskJudger::judge() {
-	isJudging = true;
-	QString contestantName = contestant->getContestantName();
+// Everything that comes before the first test case, run on the compile pool.
+// Returns false if there is nothing to run, the compile error if any already
+// being told.
+auto TaskJudger::compile() -> bool {
 	if (! temporaryDir.isValid())
-		return 0;
+		return false;
 
 	if (task->getTaskType() != Task::AnswersOnly)
-		if (! traditionalTaskPrepare())
-			return 1;
+		if (! traditionalTaskPrepare()) {
+			judged = true;
+			return false;
+		}
+
+	specialJudge = specialJudgeProgram();
+
+	if (task->getTaskType() == Task::Interaction && task->getRunInteractor())
+		interactor = taskProgram(Settings::dataPath() + task->getInteractor(), "interactor");
+
+	if (task->getComparisonMode() == Task::BatchSpecialJudgeMode)
+		batchChecker = std::make_unique<BatchChecker>(specialJudge);
+
+	return true;
+}
+
+void TaskJudger::prepare() {
+	QMutexLocker locker(&mutex);
 
 	for (int i = 0; i < task->getTestCaseList().size(); i++) {
 		timeUsed.append(QList<int>());
@@ -366,6 +766,18 @@ int TaskJudger::judge() {
 		message.append(QStringList());
 		inputFiles.append(QStringList());
 		testCaseScore.append(task->getTestCase(i)->getFullScore());
+		caseState.append(QList<CaseState>());
+		runningThreads.append(QList<JudgingThread *>());
+		subtaskState.append(SubtaskWaiting);
+		prerequisites.append(QList<int>());
+		commitCase.append(0);
+
+		// Dependences may only point to earlier subtasks, which makes the
+		// graph acyclic. Anything else (e.g. left behind by reordering the
+		// subtasks) never blocks and reads as "Pure", as it always did.
+		for (int dependence : task->getTestCase(i)->getDependenceSubtask())
+			if (0 < dependence && dependence <= i)
+				prerequisites[i].append(dependence - 1);
 
 		for (int j = 0; j < task->getTestCase(i)->getInputFiles().size(); j++) {
 			timeUsed[i].append(-1);
@@ -374,164 +786,337 @@ int TaskJudger::judge() {
 			result[i].append(Skipped);
 			message[i].append("");
 			inputFiles[i].append("");
+			caseState[i].append(CaseWaiting);
+			runningThreads[i].append(nullptr);
 		}
 	}
 
-	for (int i = 0; i < task->getTestCaseList().size(); i++) {
+	judged = true;
+	dispatch();
+}
 
-		QCoreApplication::processEvents();
-		if (! isJudging) {
-			return 0;
-		}
+// A subtask may start once all of its prerequisites are settled, or as soon as
+// one of them is lost: then its result is already known to be "Lost" and
+// there is no point in waiting for the others.
+auto TaskJudger::isSubtaskReady(int i) const -> bool {
+	bool allSettled = true;
+
+	for (int k : prerequisites[i]) {
+		if (subtaskState[k] != SubtaskSettled)
+			allSettled = false;
+		else if (overallStatus[k] < 0)
+			return true;
+	}
+
+	return allSettled;
+}
+
+// Start every waiting subtask that is ready. Prerequisites always have a
+// smaller index, so a single pass also settles chains of skipped subtasks.
+void TaskJudger::dispatch() {
+	for (int i = 0; i < subtaskState.size() && isJudging; i++) {
+		if (subtaskState[i] == SubtaskWaiting && isSubtaskReady(i))
+			startSubtask(i);
+	}
+}
+
+void TaskJudger::startSubtask(int i) {
+	auto *curTestCase = task->getTestCase(i);
+	const QList<int> &dependenceSubtask(curTestCase->getDependenceSubtask());
+
+	subtaskState[i] = SubtaskRunning;
+	overallStatus[i] = maxDependValue;
+
+	bool isSkipped = false;
+
+	for (int j = 0; j != dependenceSubtask.size(); ++j) {
+		int k = dependenceSubtask[j] - 1;
+
+		// Only reachable when a lost prerequisite cancelled this subtask early
+		if (0 <= k && k < i && subtaskState[k] != SubtaskSettled)
+			continue;
+
+		int status = 0 <= k && k < i ? overallStatus[k] : maxDependValue;
+		emit singleSubtaskDependenceFinished(i, dependenceSubtask[j], status);
+
+		if (status < 0)
+			isSkipped = true;
+
+		overallStatus[i] = qMin(overallStatus[i], status);
+	}
+
+	if (! dependenceSubtask.empty())
+		score[i].push_back(overallStatus[i]);
+
+	if (isSkipped || curTestCase->getInputFiles().empty()) {
+		subtaskState[i] = SubtaskSettled;
+		return;
+	}
+
+	for (int j = 0; j < curTestCase->getInputFiles().size(); j++) {
+		inputFiles[i][j] = QFileInfo(curTestCase->getInputFiles().at(j)).fileName();
+		caseState[i][j] = CaseQueued;
+		submit([this, i, j] { runCase(i, j); });
+	}
+}
 
-		auto curTestCase = task->getTestCase(i);
-		const QList<int> &dependenceSubtask(curTestCase->getDependenceSubtask());
+void TaskJudger::runCase(int i, int j) {
+	QString contestantName = contestant->getContestantName();
+	auto *curTestCase = task->getTestCase(i);
 
-		overallStatus[i] = maxDependValue;
+	auto *thread = new JudgingThread();
 
-		bool isSkipped = false;
+	{
+		QMutexLocker locker(&mutex);
 
-		for (int j = 0; j != dependenceSubtask.size(); ++j) {
-			int status = overallStatus[dependenceSubtask[j] - 1];
-			emit singleSubtaskDependenceFinished(i, dependenceSubtask[j], status);
+		if (! isJudging || caseState[i][j] == CaseCancelled) {
+			delete thread;
+			return;
+		}
 
-			if (status < 0)
-				isSkipped = true;
+		caseState[i][j] = CaseRunning;
+		runningThreads[i][j] = thread;
+	}
 
-			overallStatus[i] = qMin(overallStatus[i], status);
+	thread->setExtraTimeRatio(settings->getDefaultExtraTimeRatio());
+	QString workingDirectory =
+	    QDir::toNativeSeparators(QDir(QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator() +
+	                                  QString("_%1.%2").arg(i).arg(j))
+	                                 .absolutePath()) +
+	    QDir::separator();
+	thread->setWorkingDirectory(workingDirectory);
+	QDir(QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator())
+	    .mkdir(QString("_%1.%2").arg(i).arg(j));
+	QStringList entryList =
+	    QDir(QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator() + contestantName)
+	        .entryList(QDir::Files);
+
+	// Hard links are only safe when the sandbox cannot write through them
+	bool shareFiles = ProcessRunner::bindsReadOnlyFiles();
+	QStringList readOnlyFiles;
+
+	for (int fileIdx = 0; fileIdx < entryList.size(); fileIdx++) {
+		QString source = QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator() + contestantName +
+		                 QDir::separator() + entryList[fileIdx];
+
+		if (shareFiles) {
+			FileProvisioner::linkFile(source, workingDirectory + entryList[fileIdx]);
+			readOnlyFiles.append(workingDirectory + entryList[fileIdx]);
+		} else {
+			QFile::copy(source, workingDirectory + entryList[fileIdx]);
 		}
+	}
 
-		if (! dependenceSubtask.empty())
-			score[i].push_back(overallStatus[i]);
+	thread->setReadOnlyFiles(readOnlyFiles);
+	thread->setAnswerCache(answerCache);
+	thread->setVerdictCache(verdictCache);
+	thread->setCheckerPlugins(checkerPlugins);
+	thread->setBatchChecker(batchChecker.get());
+
+	thread->setSpecialJudge(specialJudge);
+	thread->setInteractor(interactor);
+	thread->setSpecialJudgeTimeLimit(settings->getSpecialJudgeTimeLimit());
+	thread->setDiffPath(settings->getDiffPath());
+
+	if (task->getTaskType() == Task::Traditional || task->getTaskType() == Task::Interaction ||
+	    task->getTaskType() == Task::Communication || task->getTaskType() == Task::CommunicationExec) {
+		if (interpreterFlag) {
+			thread->setExecutableFile(executableFile);
+		} else {
+			thread->setExecutableFile(workingDirectory + executableFile);
+		}
 
-		if (isSkipped)
-			continue;
+		thread->setArguments(arguments);
+	}
 
-		for (int j = 0; j < task->getTestCase(i)->getInputFiles().size(); j++) {
-			inputFiles[i][j] = QFileInfo(curTestCase->getInputFiles().at(j)).fileName();
+	if (task->getTaskType() == Task::AnswersOnly) {
+		QString fileName;
+		fileName = QFileInfo(curTestCase->getInputFiles().at(j)).completeBaseName();
+		fileName += QString(".") + task->getAnswerFileExtension();
 
-			testCaseScore[i] =
-			    qMin(testCaseScore[i], statusToScore(overallStatus[i], curTestCase->getFullScore()));
+		if (! task->getSubFolderCheck())
+			thread->setAnswerFile(Settings::sourcePath() + contestantName + QDir::separator() + fileName);
+		else
+			thread->setAnswerFile(Settings::sourcePath() + contestantName + QDir::separator() +
+			                      task->getSourceFileName() + QDir::separator() + fileName);
+	}
 
-			if (overallStatus[i] < 0 || isSkipped) {
-				overallStatus[i] = -1;
-				taskSkipped(std::make_pair(i, j++));
-				break;
-			}
+	thread->setTask(task);
+	thread->setInputFile(Settings::dataPath() + curTestCase->getInputFiles().at(j));
+	thread->setOutputFile(Settings::dataPath() + curTestCase->getOutputFiles().at(j));
+	thread->setFullScore(curTestCase->getFullScore());
 
-			auto *thread = new JudgingThread();
-			thread->setExtraTimeRatio(settings->getDefaultExtraTimeRatio());
-			QString workingDirectory =
-			    QDir::toNativeSeparators(QDir(QDir::toNativeSeparators(temporaryDir.path()) +
-			                                  QDir::separator() + QString("_%1.%2").arg(i).arg(j))
-			                                 .absolutePath()) +
-			    QDir::separator();
-			thread->setWorkingDirectory(workingDirectory);
-			QDir(QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator())
-			    .mkdir(QString("_%1.%2").arg(i).arg(j));
-			QStringList entryList =
-			    QDir(QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator() + contestantName)
-			        .entryList(QDir::Files);
-
-			for (int fileIdx = 0; fileIdx < entryList.size(); fileIdx++) {
-				QFile::copy(QDir::toNativeSeparators(temporaryDir.path()) + QDir::separator() +
-				                contestantName + QDir::separator() + entryList[fileIdx],
-				            workingDirectory + entryList[fileIdx]);
-			}
+	if (task->getTaskType() != Task::AnswersOnly) {
+		thread->setEnvironment(environment);
+		thread->setTimeLimit(qCeil(curTestCase->getTimeLimit() * compilerTimeLimitRatio));
+		thread->setRawTimeLimit(qCeil(curTestCase->getTimeLimit()));
 
-			thread->setSpecialJudgeTimeLimit(settings->getSpecialJudgeTimeLimit());
-			thread->setDiffPath(settings->getDiffPath());
+		if (disableMemoryLimitCheck) {
+			thread->setMemoryLimit(-1);
+		} else {
+			thread->setMemoryLimit(qCeil(curTestCase->getMemoryLimit() * compilerMemoryLimitRatio));
+		}
+		thread->setRawMemoryLimit(curTestCase->getMemoryLimit());
 
-			if (task->getTaskType() == Task::Traditional || task->getTaskType() == Task::Interaction ||
-			    task->getTaskType() == Task::Communication ||
-			    task->getTaskType() == Task::CommunicationExec) {
-				if (interpreterFlag) {
-					thread->setExecutableFile(executableFile);
-				} else {
-					thread->setExecutableFile(workingDirectory + executableFile);
-				}
+		thread->setInterpreterAsWatcher(interpreterAsWatcher);
+		thread->setRunInShell(runInShell);
+	}
 
-				thread->setArguments(arguments);
-			}
+	thread->runProgram();
 
-			if (task->getTaskType() == Task::AnswersOnly) {
-				QString fileName;
-				fileName = QFileInfo(curTestCase->getInputFiles().at(j)).completeBaseName();
-				fileName += QString(".") + task->getAnswerFileExtension();
+	while (thread->getNeedRejudge() && thread->getJudgeTimes() != settings->getRejudgeTimes() + 1 &&
+	       isJudging) {
+		thread->runProgram();
+	}
 
-				if (! task->getSubFolderCheck())
-					thread->setAnswerFile(Settings::sourcePath() + contestantName + QDir::separator() +
-					                      fileName);
-				else
-					thread->setAnswerFile(Settings::sourcePath() + contestantName + QDir::separator() +
-					                      task->getSourceFileName() + QDir::separator() + fileName);
-			}
+	// Free this slot for the next program while the output is judged
+	if (thread->hasOutputToCheck() && checkPool) {
+		QMutexLocker locker(&mutex);
+		submitCheck([this, i, j, thread] { checkCase(i, j, thread); });
+		return;
+	}
+
+	checkCase(i, j, thread);
+}
 
-			thread->setTask(task);
-			connect(this, &TaskJudger::stopJudgingSignal, thread, &JudgingThread::stopJudgingSlot);
-			thread->setInputFile(Settings::dataPath() + curTestCase->getInputFiles().at(j));
-			thread->setOutputFile(Settings::dataPath() + curTestCase->getOutputFiles().at(j));
-			thread->setFullScore(curTestCase->getFullScore());
+// Cases are committed in order whatever order their checks finish in
+void TaskJudger::checkCase(int i, int j, JudgingThread *thread) {
+	auto *curTestCase = task->getTestCase(i);
+
+	thread->checkOutput();
+
+	QMutexLocker locker(&mutex);
+	runningThreads[i][j] = nullptr;
+
+	if (caseState[i][j] == CaseRunning) {
+		timeUsed[i][j] = thread->getTimeUsed();
+		memoryUsed[i][j] = thread->getMemoryUsed();
+		score[i][j] = thread->getScore();
+		result[i][j] = thread->getResult();
+		message[i][j] = thread->getMessage();
+		caseState[i][j] = CaseFinished;
+
+		// The subtask is worth nothing now, whatever the other cases do
+		if (task->getStopOnFirstZero() &&
+		    stateToStatus(result[i][j], score[i][j], curTestCase->getFullScore()) < 0) {
+			for (int k = 0; k < caseState[i].size(); k++)
+				if (caseState[i][k] != CaseFinished)
+					cancelCase(i, k);
+		}
+	}
 
-			if (task->getTaskType() != Task::AnswersOnly) {
-				thread->setEnvironment(environment);
-				thread->setTimeLimit(qCeil(curTestCase->getTimeLimit() * compilerTimeLimitRatio));
-				thread->setRawTimeLimit(qCeil(curTestCase->getTimeLimit()));
+	delete thread;
 
-				if (disableMemoryLimitCheck) {
-					thread->setMemoryLimit(-1);
-				} else {
-					thread->setMemoryLimit(qCeil(curTestCase->getMemoryLimit() * compilerMemoryLimitRatio));
-				}
-				thread->setRawMemoryLimit(curTestCase->getMemoryLimit());
+	if (isJudging) {
+		commit(i);
+		dispatch();
+	}
+}
 
-				thread->setInterpreterAsWatcher(interpreterAsWatcher);
-			}
-			thread->start();
-			thread->wait();
+// Walk the finished test cases of a subtask in order, so that the subtask
+// minimum and the singleCaseFinished signals behave exactly as if the cases
+// had been judged one after another. Must be called with `mutex` held.
+void TaskJudger::commit(int i) {
+	auto *curTestCase = task->getTestCase(i);
+	int caseCount = curTestCase->getInputFiles().size();
 
-			QCoreApplication::processEvents();
-			if (! isJudging) {
-				delete thread;
-				return 0;
-			}
+	while (subtaskState[i] == SubtaskRunning) {
+		int j = commitCase[i];
 
-			while (thread->getNeedRejudge() && thread->getJudgeTimes() != settings->getRejudgeTimes() + 1 &&
-			       isJudging) {
-				thread->start();
-				thread->wait();
-				QCoreApplication::processEvents();
-			}
-			timeUsed[i][j] = thread->getTimeUsed();
-			memoryUsed[i][j] = thread->getMemoryUsed();
-			score[i][j] = thread->getScore();
-			result[i][j] = thread->getResult();
-			overallStatus[i] = qMin(overallStatus[i], stateToStatus(thread->getResult(), thread->getScore(),
-			                                                        thread->getFullScore()));
-			message[i][j] = thread->getMessage();
-			delete thread;
-			int nowScore = score[i][j];
+		if (j == caseCount) {
+			subtaskState[i] = SubtaskSettled;
+			break;
+		}
 
-			if (j + 1 == task->getTestCase(i)->getInputFiles().size()) {
-				for (int k = 0; k < j; k++)
-					nowScore = qMin(nowScore, score[i][k]);
+		testCaseScore[i] =
+		    qMin(testCaseScore[i], statusToScore(overallStatus[i], curTestCase->getFullScore()));
 
-				if (! task->getTestCase(i)->getDependenceSubtask().empty())
-					nowScore =
-					    qMin(nowScore, statusToScore(overallStatus[i], task->getTestCase(i)->getFullScore()));
-			}
+		if (overallStatus[i] < 0) {
+			overallStatus[i] = -1;
+			cancelSubtask(i, j);
+
+			if (task->getStopOnFirstZero()) {
+				for (int k = j; k < caseCount; k++)
+					taskSkipped(std::make_pair(i, k));
+			} else
+				taskSkipped(std::make_pair(i, j));
+
+			subtaskState[i] = SubtaskSettled;
+			break;
+		}
+
+		// Stopped because a later case of the subtask already scored zero
+		if (caseState[i][j] == CaseCancelled) {
+			taskSkipped(std::make_pair(i, j));
+			commitCase[i]++;
+			continue;
+		}
+
+		if (caseState[i][j] != CaseFinished)
+			return;
 
-			emit singleCaseFinished(
-			    contestantName, task->getTestCase(i)->getTimeLimit(), i, j, int(result[i][j]),
-			    (j + 1 == task->getTestCase(i)->getInputFiles().size() ? 1 : -1) * nowScore, timeUsed[i][j],
-			    memoryUsed[i][j]);
+		overallStatus[i] = qMin(overallStatus[i],
+		                        stateToStatus(result[i][j], score[i][j], curTestCase->getFullScore()));
+		int nowScore = score[i][j];
 
-			if (score[i][j] < testCaseScore[i])
-				testCaseScore[i] = score[i][j];
+		if (j + 1 == caseCount) {
+			for (int k = 0; k < j; k++)
+				nowScore = qMin(nowScore, score[i][k]);
+
+			if (! curTestCase->getDependenceSubtask().empty())
+				nowScore = qMin(nowScore, statusToScore(overallStatus[i], curTestCase->getFullScore()));
 		}
+
+		emit singleCaseFinished(contestant->getContestantName(), curTestCase->getTimeLimit(), i, j,
+		                        int(result[i][j]), (j + 1 == caseCount ? 1 : -1) * nowScore, timeUsed[i][j],
+		                        memoryUsed[i][j]);
+
+		if (score[i][j] < testCaseScore[i])
+			testCaseScore[i] = score[i][j];
+
+		commitCase[i]++;
 	}
+}
+
+// The subtask is already lost, so the rest of its cases cannot change the
+// score. Drop the queued ones, stop the running ones and forget whatever has
+// already finished, leaving them as Skipped.
+void TaskJudger::cancelSubtask(int i, int from) {
+	for (int j = from; j < caseState[i].size(); j++)
+		cancelCase(i, j);
+}
+
+void TaskJudger::cancelCase(int i, int j) {
+	if (caseState[i][j] == CaseRunning && runningThreads[i][j])
+		runningThreads[i][j]->stopJudgingSlot();
+
+	caseState[i][j] = CaseCancelled;
+	timeUsed[i][j] = -1;
+	memoryUsed[i][j] = -1;
+	score[i][j] = 0;
+	result[i][j] = Skipped;
+	message[i][j] = "";
+}
+
+void TaskJudger::finish() {
+	// Nothing is left to check, so the idle checkers may go
+	batchChecker.reset();
 
-	return 1;
+	if (judged && isJudging) {
+		contestant->setCheckJudged(taskId, true);
+		contestant->setCompileMessage(taskId, compileMessage);
+		contestant->setCompileState(taskId, compileState);
+		contestant->setResult(taskId, result);
+		contestant->setMessage(taskId, message);
+		contestant->setTimeUsed(taskId, timeUsed);
+		contestant->setMemoryUsed(taskId, memoryUsed);
+		contestant->setScore(taskId, score);
+		contestant->setInputFiles(taskId, inputFiles);
+		contestant->setSourceFile(taskId, sourceFile);
+	} else {
+		contestant->setCheckJudged(taskId, false);
+	}
+	emit judgingFinished();
 }
 
 void TaskJudger::makeDialogAlert(QString msg) { emit dialogAlert(std::move(msg)); }
@@ -540,4 +1125,14 @@ void TaskJudger::taskSkipped(const std::pair<int, int> &cur) {
 	                        cur.first, cur.second, int(result[cur.first][cur.second]), 0, 0, 0);
 }
 
-void TaskJudger::stop() { isJudging = false; }
+void TaskJudger::stop() {
+	isJudging = false;
+	stopSignal.raise();
+	compileStop.raise();
+	QMutexLocker locker(&mutex);
+
+	for (const auto &threads : std::as_const(runningThreads))
+		for (auto *thread : threads)
+			if (thread)
+				thread->stopJudgingSlot();
+}
@@ -8,18 +8,33 @@
 #pragma once
 
 #include "base/LemonType.hpp"
+#include "core/batchchecker.h"
+#include "core/buildcache.h"
 #include "core/judgingthread.h"
 
 #include <QList>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QString>
 #include <QStringList>
 #include <QTemporaryDir>
 
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class AnswerCache;
+class CheckerPlugins;
+class CompileCache;
+class CompilerProfiles;
+struct CompilerProfile;
+class Compiler;
 class Contestant;
+class JudgingPool;
 class Settings;
 class Task;
+class VerdictCache;
 
 class TaskJudger : public QObject {
 	Q_OBJECT
@@ -31,6 +46,15 @@ class TaskJudger : public QObject {
 	void setTask(Task *);
 	void setTaskId(int);
 	void setContestant(Contestant *);
+	void setJudgingPool(JudgingPool *);
+	void setCheckPool(JudgingPool *);
+	void setCompilePool(JudgingPool *);
+	void setAnswerCache(AnswerCache *);
+	void setVerdictCache(VerdictCache *);
+	void setCheckerPlugins(CheckerPlugins *);
+	void setBuildCache(BuildCache *);
+	void setCompileCache(CompileCache *);
+	void setCompilerProfiles(const CompilerProfiles *);
 	Contestant *getContestant() const;
 	CompileState getCompileState() const;
 	// const QList< std::pair<int, int> >& getNeedRejudge() const;
@@ -49,10 +73,13 @@ class TaskJudger : public QObject {
 	QString executableFile;
 	QString arguments;
 	QString diffPath;
+	QString specialJudge;
+	QString interactor;
 	double compilerTimeLimitRatio{};
 	double compilerMemoryLimitRatio{};
 	bool disableMemoryLimitCheck{};
 	bool interpreterAsWatcher{};
+	bool runInShell{};
 	QProcessEnvironment environment;
 	QList<int> overallStatus;
 	QList<QList<int>> timeUsed;
@@ -63,22 +90,87 @@ class TaskJudger : public QObject {
 	QList<QStringList> inputFiles;
 
 	QList<int> testCaseScore;
-	bool isJudging;
+	std::atomic<bool> isJudging{false};
+	// Interrupts the compilers, the test cases have their own
+	StopSignal stopSignal;
+	// Raised along with stopSignal, or by the first unit of a compile to fail
+	StopSignal compileStop;
 	int taskId;
 	bool traditionalTaskPrepare();
-	void assign();
+	QString specialJudgeProgram();
+	QString taskProgram(const QString &source, const QString &name);
+	QStringList prebuildGraders(const CompilerProfile &, const QString &arguments,
+	                            const QList<QPair<QString, QString>> &files, const QStringList &sources,
+	                            const QString &targetDirectory);
+	bool prebuildProgram(const CompilerProfile &, const QString &arguments,
+	                     const QList<QPair<QString, QString>> &files, const QString &source,
+	                     const QString &name, const QString &targetDirectory);
+	bool installBuild(const BuildCache::Job &, const QString &targetDirectory);
+	QString precompiledHeader(const CompilerProfile &, const QString &arguments, const QString &directory);
+	bool runCompiler(const Compiler *, const QStringList &arguments, const QString &directory,
+	                 const QStringList &units = {});
 	void taskSkipped(const std::pair<int, int> &);
 	void makeDialogAlert(QString);
-	int judge();
+
+	// Test cases are run as independent jobs on the shared JudgingPool and
+	// committed back in case order within each subtask. Subtasks form a DAG
+	// through their dependences and run concurrently once their prerequisites
+	// are settled. Everything below is guarded by `mutex` once the cases have
+	// been dispatched.
+	enum CaseState { CaseWaiting, CaseQueued, CaseRunning, CaseFinished, CaseCancelled };
+	enum SubtaskState { SubtaskWaiting, SubtaskRunning, SubtaskSettled };
+	JudgingPool *pool{};
+	// Outputs are judged there, if set, so that a slow checker does not hold
+	// up the next program
+	JudgingPool *checkPool{};
+	// Where compileIt() compiles, apart from the programs being run
+	JudgingPool *compilePool{};
+	AnswerCache *answerCache{};
+	VerdictCache *verdictCache{};
+	CheckerPlugins *checkerPlugins{};
+	BuildCache *buildCache{};
+	CompileCache *compileCache{};
+	const CompilerProfiles *compilerProfiles{};
+	// Shared by the test cases of this contestant, unlike the plugins
+	std::unique_ptr<BatchChecker> batchChecker;
+	int poolQueue{};
+	int checkQueue{};
+	QMutex mutex;
+	int outstandingJobs{};
+	bool judged{};
+	bool finished{};
+	QList<QList<CaseState>> caseState;
+	QList<QList<JudgingThread *>> runningThreads;
+	QList<SubtaskState> subtaskState;
+	QList<QList<int>> prerequisites;
+	QList<int> commitCase;
+	void submit(std::function<void()>);
+	void submitCheck(std::function<void()>);
+	void jobFinished();
+	bool compile();
+	void prepare();
+	bool isSubtaskReady(int) const;
+	void dispatch();
+	void startSubtask(int);
+	void runCase(int, int);
+	void checkCase(int, int, JudgingThread *);
+	void commit(int);
+	void cancelSubtask(int, int);
+	void cancelCase(int, int);
+	void finish();
 
 	QTemporaryDir temporaryDir;
 
   public:
+	// Compiles, then emits compiled(), or finishes if there is nothing to run
+	void compileIt();
+	// Runs the test cases, once compiled
 	void judgeIt();
   public slots:
 	void stop();
   signals:
 	void judgingStarted(QString);
+	void compiled();
 	void judgingFinished();
 	void dialogAlert(QString);
 	void singleCaseFinished(QString, int, int, int, int, int, int, qint64);
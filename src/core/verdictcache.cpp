@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "verdictcache.h"
+#include "core/outputreader.h"
+
+#include <QByteArrayView>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+
+VerdictCache::VerdictCache() {
+	for (auto &seed : seeds)
+		seed = static_cast<size_t>(QRandomGenerator::system()->generate64());
+}
+
+auto VerdictCache::find(const QByteArray &key, Verdict &verdict) const -> bool {
+	QMutexLocker locker(&mutex);
+	auto it = verdicts.constFind(key);
+
+	if (it == verdicts.constEnd())
+		return false;
+
+	verdict = *it;
+	return true;
+}
+
+void VerdictCache::insert(const QByteArray &key, const Verdict &verdict) {
+	QMutexLocker locker(&mutex);
+	verdicts.insert(key, verdict);
+}
+
+auto VerdictCache::fileHash(const QString &fileName) -> QByteArray {
+	QFileInfo info(fileName);
+	const QString path = info.absoluteFilePath();
+
+	{
+		QMutexLocker locker(&mutex);
+		auto it = fileHashes.constFind(path);
+
+		if (it != fileHashes.constEnd() && it->modified == info.lastModified() && it->size == info.size())
+			return it->hash;
+	}
+
+	OutputReader file(path);
+
+	if (! file.valid())
+		return {};
+
+	QByteArray result = hash(file.contents());
+	QMutexLocker locker(&mutex);
+	fileHashes.insert(path, {info.lastModified(), info.size(), result});
+	return result;
+}
+
+auto VerdictCache::hash(std::string_view data) const -> QByteArray {
+	QByteArrayView view(data.data(), static_cast<qsizetype>(data.size()));
+	// Two differently seeded hashes and the size, as qHash() may be 32 bits
+	const quint64 parts[] = {qHash(view, seeds[0]), qHash(view, seeds[1]), data.size()};
+
+	return QByteArray(reinterpret_cast<const char *>(parts), sizeof(parts));
+}
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Project LemonLime
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#pragma once
+
+#include "base/LemonType.hpp"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <string_view>
+
+// Verdicts of a judge session by what they were given, for the tasks that
+// opt in: most contestants write the same correct output, which then costs a
+// hash instead of another comparison or special judge run.
+//
+// JudgingThread makes up the key: the task and test case, the comparison
+// settings, the contents of the special judge and the contents of the output.
+class VerdictCache {
+  public:
+	struct Verdict {
+		int score{};
+		ResultState result{};
+		QString message;
+		// The comparison left the message of the run alone
+		bool keepMessage{};
+	};
+
+	VerdictCache();
+
+	// Both thread-safe
+	bool find(const QByteArray &key, Verdict &) const;
+	void insert(const QByteArray &key, const Verdict &);
+
+	// Hash of the contents of a file, such as a special judge, kept until it
+	// is modified. Empty if it cannot be read.
+	QByteArray fileHash(const QString &fileName);
+
+	// Fast and not cryptographic, but wide enough for the outputs of a
+	// session, and seeded at random so that no one can aim for a collision
+	QByteArray hash(std::string_view) const;
+
+  private:
+	struct FileHash {
+		QDateTime modified;
+		qint64 size{};
+		QByteArray hash;
+	};
+
+	size_t seeds[2]{};
+	mutable QMutex mutex;
+	QHash<QByteArray, Verdict> verdicts;
+	QHash<QString, FileHash> fileHashes;
+};
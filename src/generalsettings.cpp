@@ -41,6 +41,7 @@ GeneralSettings::GeneralSettings(QWidget *parent) : QWidget(parent), ui(new Ui::
 	ui->fileSizeLimit->setValidator(new QIntValidator(1, Settings::upperBoundForFileSizeLimit(), this));
 	ui->rejudgeTimes->setValidator(new QIntValidator(0, Settings::upperBoundForRejudgeTimes(), this));
 	ui->maxJudgingThreads->setValidator(new QIntValidator(1, QThread::idealThreadCount() * 2, this));
+	ui->maxCompilingThreads->setValidator(new QIntValidator(1, QThread::idealThreadCount() * 2, this));
 	ui->inputFileExtensions->setValidator(
 	    new QRegularExpressionValidator(QRegularExpression("(\\w+;)*\\w+"), this));
 	ui->outputFileExtensions->setValidator(
@@ -57,6 +58,8 @@ GeneralSettings::GeneralSettings(QWidget *parent) : QWidget(parent), ui(new Ui::
 	connect(ui->fileSizeLimit, &QLineEdit::textChanged, this, &GeneralSettings::fileSizeLimitChanged);
 	connect(ui->rejudgeTimes, &QLineEdit::textChanged, this, &GeneralSettings::rejudgeTimesChanged);
 	connect(ui->maxJudgingThreads, &QLineEdit::textChanged, this, &GeneralSettings::maxJudgingThreadsChanged);
+	connect(ui->maxCompilingThreads, &QLineEdit::textChanged, this,
+	        &GeneralSettings::maxCompilingThreadsChanged);
 	connect(ui->inputFileExtensions, &QLineEdit::textChanged, this,
 	        &GeneralSettings::inputFileExtensionsChanged);
 	connect(ui->outputFileExtensions, &QLineEdit::textChanged, this,
@@ -78,6 +81,7 @@ void GeneralSettings::resetEditSettings(Settings *settings) {
 	ui->fileSizeLimit->setText(QString("%1").arg(editSettings->getFileSizeLimit()));
 	ui->rejudgeTimes->setText(QString("%1").arg(editSettings->getRejudgeTimes()));
 	ui->maxJudgingThreads->setText(QString("%1").arg(editSettings->getMaxJudgingThreads()));
+	ui->maxCompilingThreads->setText(QString("%1").arg(editSettings->getMaxCompilingThreads()));
 	ui->inputFileExtensions->setText(editSettings->getInputFileExtensions().join(";"));
 	ui->outputFileExtensions->setText(editSettings->getOutputFileExtensions().join(";"));
 	ui->languageComboBox->setCurrentText(editSettings->getUiLanguage());
@@ -171,6 +175,10 @@ void GeneralSettings::maxJudgingThreadsChanged(const QString &text) {
 	editSettings->setMaxJudgingThreads(text.toInt());
 }
 
+void GeneralSettings::maxCompilingThreadsChanged(const QString &text) {
+	editSettings->setMaxCompilingThreads(text.toInt());
+}
+
 void GeneralSettings::inputFileExtensionsChanged(const QString &text) {
 	editSettings->setInputFileExtensions(text);
 }
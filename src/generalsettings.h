@@ -41,6 +41,7 @@ class GeneralSettings : public QWidget {
 	void fileSizeLimitChanged(const QString &);
 	void rejudgeTimesChanged(const QString &);
 	void maxJudgingThreadsChanged(const QString &);
+	void maxCompilingThreadsChanged(const QString &);
 	void inputFileExtensionsChanged(const QString &);
 	void outputFileExtensionsChanged(const QString &);
 	void onLanguageComboBoxChanged(const QString &);
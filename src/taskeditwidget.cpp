@@ -19,10 +19,14 @@ TaskEditWidget::TaskEditWidget(QWidget *parent) : QWidget(parent), ui(new Ui::Ta
 	editTask = nullptr;
 	ui->lemonSpecialJudge->setFilters(QDir::Files | QDir::Executable);
 	ui->testlibSpecialJudge->setFilters(QDir::Files | QDir::Executable);
+	ui->checkerPlugin->setFilters(QDir::Files);
+	ui->batchSpecialJudge->setFilters(QDir::Files | QDir::Executable);
 	ui->interactorPath->setFilters(QDir::Files);
 	ui->graderPath->setFilters(QDir::Files);
 	connect(this, &TaskEditWidget::dataPathChanged, ui->lemonSpecialJudge, &FileLineEdit::refreshFileList);
 	connect(this, &TaskEditWidget::dataPathChanged, ui->testlibSpecialJudge, &FileLineEdit::refreshFileList);
+	connect(this, &TaskEditWidget::dataPathChanged, ui->checkerPlugin, &FileLineEdit::refreshFileList);
+	connect(this, &TaskEditWidget::dataPathChanged, ui->batchSpecialJudge, &FileLineEdit::refreshFileList);
 	connect(this, &TaskEditWidget::dataPathChanged, ui->interactorPath, &FileLineEdit::refreshFileList);
 	connect(this, &TaskEditWidget::dataPathChanged, ui->graderPath, &FileLineEdit::refreshFileList);
 	ui->sourceFileName->setValidator(new QRegularExpressionValidator(QRegularExpression("\\w+"), this));
@@ -51,6 +55,14 @@ TaskEditWidget::TaskEditWidget(QWidget *parent) : QWidget(parent), ui(new Ui::Ta
 	        &TaskEditWidget::standardInputCheckChanged);
 	connect(ui->standardOutputCheck, &QCheckBox::checkStateChanged, this,
 	        &TaskEditWidget::standardOutputCheckChanged);
+	connect(ui->stopOnFirstZeroCheck, &QCheckBox::checkStateChanged, this,
+	        &TaskEditWidget::stopOnFirstZeroCheckChanged);
+	connect(ui->checkWhileRunningCheck, &QCheckBox::checkStateChanged, this,
+	        &TaskEditWidget::checkWhileRunningCheckChanged);
+	connect(ui->cacheVerdictsCheck, &QCheckBox::checkStateChanged, this,
+	        &TaskEditWidget::cacheVerdictsCheckChanged);
+	connect(ui->runInteractorCheck, &QCheckBox::checkStateChanged, this,
+	        &TaskEditWidget::runInteractorCheckChanged);
 	connect(ui->comparisonMode, qOverload<int>(&QComboBox::currentIndexChanged), this,
 	        &TaskEditWidget::comparisonModeChanged);
 	connect(ui->diffArguments, &QLineEdit::textChanged, this, &TaskEditWidget::diffArgumentsChanged);
@@ -58,6 +70,8 @@ TaskEditWidget::TaskEditWidget(QWidget *parent) : QWidget(parent), ui(new Ui::Ta
 	        &TaskEditWidget::realPrecisionChanged);
 	connect(ui->lemonSpecialJudge, &QLineEdit::textChanged, this, &TaskEditWidget::specialJudgeChanged);
 	connect(ui->testlibSpecialJudge, &QLineEdit::textChanged, this, &TaskEditWidget::specialJudgeChanged);
+	connect(ui->checkerPlugin, &QLineEdit::textChanged, this, &TaskEditWidget::specialJudgeChanged);
+	connect(ui->batchSpecialJudge, &QLineEdit::textChanged, this, &TaskEditWidget::specialJudgeChanged);
 	connect(ui->interactorPath, &QLineEdit::textChanged, this, &TaskEditWidget::interactorChanged);
 	connect(ui->interactorName, &QLineEdit::textChanged, this, &TaskEditWidget::interactorNameChanged);
 	connect(ui->graderPath, &QLineEdit::textChanged, this, &TaskEditWidget::graderChanged);
@@ -115,11 +129,17 @@ void TaskEditWidget::setEditTask(Task *task) {
 	ui->realPrecision->setValue(editTask->getRealPrecision());
 	ui->lemonSpecialJudge->setText(editTask->getSpecialJudge());
 	ui->testlibSpecialJudge->setText(editTask->getSpecialJudge());
+	ui->checkerPlugin->setText(editTask->getSpecialJudge());
+	ui->batchSpecialJudge->setText(editTask->getSpecialJudge());
 	ui->interactorPath->setText(editTask->getInteractor());
 	ui->interactorName->setText(editTask->getInteractorName());
 	ui->graderPath->setText(editTask->getGrader());
 	ui->standardInputCheck->setChecked(editTask->getStandardInputCheck());
 	ui->standardOutputCheck->setChecked(editTask->getStandardOutputCheck());
+	ui->stopOnFirstZeroCheck->setChecked(editTask->getStopOnFirstZero());
+	ui->checkWhileRunningCheck->setChecked(editTask->getCheckWhileRunning());
+	ui->cacheVerdictsCheck->setChecked(editTask->getCacheVerdicts());
+	ui->runInteractorCheck->setChecked(editTask->getRunInteractor());
 	// ui->interactorPathLabel->setVisible(editTask->getTaskType() == Task::Interaction);
 	// ui->interactorPath->setVisible(editTask->getTaskType() == Task::Interaction);
 	// ui->graderPathLabel->setVisible(editTask->getTaskType() == Task::Interaction);
@@ -159,10 +179,13 @@ void TaskEditWidget::refreshWidgetState() {
 	int types = editTask->getTaskType();
 	ui->interactorPathLabel->setVisible(types == Task::Interaction);
 	ui->interactorPath->setVisible(types == Task::Interaction);
-	ui->graderPathLabel->setVisible(types == Task::Interaction);
-	ui->graderPath->setVisible(types == Task::Interaction);
-	ui->interactorNameLabel->setVisible(types == Task::Interaction);
-	ui->interactorName->setVisible(types == Task::Interaction);
+	// A separate interactor is not compiled with the contestant's code
+	bool linksInteractor = types == Task::Interaction && ! editTask->getRunInteractor();
+	ui->graderPathLabel->setVisible(linksInteractor);
+	ui->graderPath->setVisible(linksInteractor);
+	ui->interactorNameLabel->setVisible(linksInteractor);
+	ui->interactorName->setVisible(linksInteractor);
+	ui->runInteractorCheck->setVisible(types == Task::Interaction);
 	// ui->comparisonSetting->setVisible(types != Task::Interaction);
 	ui->sourceFileName->setEnabled(types == Task::Traditional || types == Task::Interaction ||
 	                               types == Task::AnswersOnly || types == Task::Communication ||
@@ -197,6 +220,8 @@ void TaskEditWidget::refreshWidgetState() {
 	                                    types == Task::Communication || types == Task::CommunicationExec);
 	ui->standardOutputCheck->setVisible(types == Task::Traditional || types == Task::Interaction ||
 	                                    types == Task::Communication || types == Task::CommunicationExec);
+	ui->checkWhileRunningCheck->setVisible(types == Task::Traditional || types == Task::Interaction ||
+	                                       types == Task::Communication || types == Task::CommunicationExec);
 	ui->compilerSettingsLabel->setVisible(types == Task::Traditional || types == Task::Interaction ||
 	                                      types == Task::Communication || types == Task::CommunicationExec);
 	ui->compilersList->setVisible(types == Task::Traditional || types == Task::Interaction ||
@@ -339,6 +364,35 @@ void TaskEditWidget::standardOutputCheckChanged() {
 	ui->outputFileName->setEnabled(! check);
 }
 
+void TaskEditWidget::stopOnFirstZeroCheckChanged() {
+	if (! editTask)
+		return;
+
+	editTask->setStopOnFirstZero(ui->stopOnFirstZeroCheck->isChecked());
+}
+
+void TaskEditWidget::checkWhileRunningCheckChanged() {
+	if (! editTask)
+		return;
+
+	editTask->setCheckWhileRunning(ui->checkWhileRunningCheck->isChecked());
+}
+
+void TaskEditWidget::cacheVerdictsCheckChanged() {
+	if (! editTask)
+		return;
+
+	editTask->setCacheVerdicts(ui->cacheVerdictsCheck->isChecked());
+}
+
+void TaskEditWidget::runInteractorCheckChanged() {
+	if (! editTask)
+		return;
+
+	editTask->setRunInteractor(ui->runInteractorCheck->isChecked());
+	refreshWidgetState();
+}
+
 void TaskEditWidget::comparisonModeChanged() {
 	if (! editTask)
 		return;
@@ -53,6 +53,10 @@ class TaskEditWidget : public QWidget {
 	void outputFileNameChanged(const QString &);
 	void standardInputCheckChanged();
 	void standardOutputCheckChanged();
+	void stopOnFirstZeroCheckChanged();
+	void checkWhileRunningCheckChanged();
+	void cacheVerdictsCheckChanged();
+	void runInteractorCheckChanged();
 	void comparisonModeChanged();
 	void diffArgumentsChanged(const QString &);
 	void realPrecisionChanged(int);
@@ -9,6 +9,7 @@
 #include "base/settings.h"
 #include "core/contest.h"
 #include "core/contestant.h"
+#include "core/judgingthread.h"
 #include "core/task.h"
 #include "core/testcase.h"
 
@@ -114,6 +115,30 @@ static Contest *loadContest(const QString &contestDir, Settings *settings, QObje
 	return contest;
 }
 
+// ---------------------------------------------------------------------------
+// Helper: write `contents` to `fileName`, false if it cannot be written.
+// ---------------------------------------------------------------------------
+static bool writeFile(const QString &fileName, const QByteArray &contents) {
+	QFile file(fileName);
+	return file.open(QFile::WriteOnly) && file.write(contents) == contents.size();
+}
+
+// ---------------------------------------------------------------------------
+// Helper: build a single C++ source with g++ into `directory`, returning the
+// executable or an empty string on failure.
+// ---------------------------------------------------------------------------
+static QString compileProgram(const QString &directory, const QByteArray &source) {
+	const QString sourceFile = directory + "/program.cpp";
+	const QString executableFile = directory + "/program";
+	if (! writeFile(sourceFile, source))
+		return {};
+
+	const QString gppPath = QStandardPaths::findExecutable("g++");
+	if (gppPath.isEmpty() || QProcess::execute(gppPath, {sourceFile, "-o", executableFile, "-O2"}) != 0)
+		return {};
+	return executableFile;
+}
+
 // ===========================================================================
 // Test class
 // ===========================================================================
@@ -378,6 +403,84 @@ class TestContest : public QObject {
 		delete contest;
 		delete contest2;
 	}
+
+	// ------------------------------------------------------------------
+	// Test 6: checking the output while the program runs keeps the verdict
+	// of a program that crashes after writing a correct prefix, instead of
+	// turning it into a wrong answer for the output being short.
+	// ------------------------------------------------------------------
+	void testCheckWhileRunningKeepsCrash() {
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+
+		const QString executableFile = compileProgram(dir.path(), R"(#include <cstdio>
+#include <cstdlib>
+int main() {
+	std::puts("1");
+	std::fflush(stdout);
+	std::abort();
+}
+)");
+		QVERIFY2(! executableFile.isEmpty(), "Failed to compile the test program");
+
+		const QString workingDirectory = dir.path() + "/work/";
+		QVERIFY(QDir().mkpath(workingDirectory));
+		QVERIFY(writeFile(dir.path() + "/1.in", ""));
+		QVERIFY(writeFile(dir.path() + "/1.ans", "1\n2\n"));
+
+		Task task;
+		task.setTaskType(Task::Traditional);
+		task.setComparisonMode(Task::IgnoreSpacesMode);
+		task.setStandardInputCheck(true);
+		task.setStandardOutputCheck(true);
+		task.setCheckWhileRunning(true);
+
+		JudgingThread thread;
+		thread.setTask(&task);
+		thread.setWorkingDirectory(workingDirectory);
+		thread.setExecutableFile(executableFile);
+		thread.setInputFile(dir.path() + "/1.in");
+		thread.setOutputFile(dir.path() + "/1.ans");
+		thread.setFullScore(10);
+		thread.setTimeLimit(1000);
+		thread.setRawTimeLimit(1000);
+		thread.setMemoryLimit(512);
+		thread.setRawMemoryLimit(512);
+		thread.setExtraTimeRatio(0.2);
+		thread.run();
+
+		qDebug() << thread.getMessage();
+		QVERIFY2(thread.getResult() == RunTimeError,
+		         qPrintable(QString("Expected RE, got %1").arg(thread.getResult())));
+		QCOMPARE(thread.getScore(), 0);
+	}
+
+	// ------------------------------------------------------------------
+	// Test 7: the comparison done in place of diff rejects extra lines as
+	// too much output, like the other comparators.
+	// ------------------------------------------------------------------
+	void testDiffTooMuchContents() {
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		QVERIFY(writeFile(dir.path() + "/1.ans", "1\n2\n"));
+		QVERIFY(writeFile(dir.path() + "/1.out", "1\n2\n3\n"));
+
+		Task task;
+		task.setTaskType(Task::AnswersOnly);
+		task.setComparisonMode(Task::ExternalToolMode);
+
+		JudgingThread thread;
+		thread.setTask(&task);
+		thread.setAnswerFile(dir.path() + "/1.out");
+		thread.setOutputFile(dir.path() + "/1.ans");
+		thread.setFullScore(10);
+		thread.run();
+
+		QVERIFY2(thread.getResult() == OutputLimitExceeded,
+		         qPrintable(QString("Expected OLE, got %1").arg(thread.getResult())));
+		QVERIFY2(thread.getMessage().contains("too much contents"), qPrintable(thread.getMessage()));
+		QCOMPARE(thread.getScore(), 0);
+	}
 };
 
 QTEST_GUILESS_MAIN(TestContest)
@@ -0,0 +1,7 @@
+#include <stdlib.h>
+
+int main() {
+	// Reserve 1 GiB of address space without touching it
+	void *p = malloc(1 << 30);
+	return p == NULL;
+}
@@ -0,0 +1,26 @@
+import subprocess
+import os
+
+pid = os.getpid()
+tmpout = f"_tmpout_{pid}"
+tmperr = f"_tmperr_{pid}"
+
+def run(args, *extra):
+    p = subprocess.Popen(["./watcher_unix", "./args", args, "", tmpout, tmperr, "1000", "100", "1000", "100", "", "", *extra], shell=False, stdout=subprocess.PIPE)
+    code = p.wait()
+    with open(tmpout, 'r') as f:
+        return code, f.read()
+
+# Executed directly: quotes and backslashes split the words, nothing is expanded
+code, out = run("a  \"b c\" 'd \"e' f\\ g \"h\\\"i\" '' $HOME *")
+assert(code == 0)
+assert(out == "[a]\n[b c]\n[d \"e]\n[f g]\n[h\"i]\n[]\n[$HOME]\n[*]\n")
+
+code, out = run("'a b")
+assert(code == 2)
+
+# Through the shell, only when asked for
+os.environ["LEMON_TEST"] = "x y"
+code, out = run("$LEMON_TEST", "shell")
+assert(code == 0)
+assert(out == "[x]\n[y]\n")
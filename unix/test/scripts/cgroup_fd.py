@@ -0,0 +1,20 @@
+import subprocess
+import os
+
+pid = os.getpid()
+tmperr = f"_tmperr_{pid}"
+
+args = ["./watcher_unix", "./reserve", "", "", "", tmperr, "1000", "100", "1000", "100", "", ""]
+
+# RLIMIT_AS makes reserving address space fail
+p = subprocess.Popen(args, shell=False, stdout=subprocess.PIPE)
+p.communicate()
+assert(p.wait() == 2)
+
+# In a cgroup only the memory actually used counts. Any writable descriptor
+# stands in for cgroup.procs here.
+fd = os.open("/dev/null", os.O_WRONLY)
+env = dict(os.environ, LEMON_CGROUP_FD=str(fd))
+p = subprocess.Popen(args, shell=False, stdout=subprocess.PIPE, env=env, pass_fds=[fd])
+p.communicate()
+assert(p.wait() == 0)
@@ -0,0 +1,69 @@
+import array
+import os
+import socket
+import subprocess
+import tempfile
+
+pid = os.getpid()
+tmpout = f"_tmpout_{pid}"
+tmperr = f"_tmperr_{pid}"
+scratch = tempfile.mkdtemp()
+
+judge, zygote = socket.socketpair(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+p = subprocess.Popen(["./watcher_unix", "--zygote", scratch], stdin=zygote, stdout=subprocess.DEVNULL)
+zygote.close()
+
+
+def record(args, fd_index=-1):
+    env = [f"PATH={os.environ['PATH']}"]
+    fields = [os.getcwd(), str(len(args))] + args + [str(len(env))] + env + [str(fd_index)]
+    return b"".join(field.encode() + b"\0" for field in fields)
+
+
+def send(records, fds=[]):
+    ancillary = [(socket.SOL_SOCKET, socket.SCM_RIGHTS, array.array("i", fds))] if fds else []
+    judge.sendmsg([b"".join(records)], ancillary)
+
+
+def result():
+    header, _, message = judge.recv(1 << 20).partition(b"\n")
+    code, time, memory = map(int, header.split())
+    return code, time, memory, message
+
+
+def limits(program, out=""):
+    return [program, "", "", out, tmperr, "1000", "100", "1000", "100", "", ""]
+
+
+# Several runs through one zygote, each with its own result
+send([record(limits("./hello", tmpout))])
+code, time, memory, _ = result()
+assert(code == 0 and time >= 0 and memory > 0)
+with open(tmpout, 'r') as f:
+    assert(f.read() == "Hello World!\n")
+
+open(os.path.join(scratch, "left-behind"), "w").close()
+send([record(limits("./re"))])
+assert(result()[0] == 2)
+# The scratch directories are emptied after every run
+assert(os.listdir(scratch) == [])
+
+# A batch is answered record by record, in order
+send([record(limits("./hello")), record(limits("./re")), record(limits("./tle"))])
+assert([result()[0] for _ in range(3)] == [0, 2, 3])
+
+# The cgroup.procs descriptors travel with the request
+fd = os.open("/dev/null", os.O_WRONLY)
+send([record(limits("./reserve")), record(limits("./reserve"), 0)], [fd])
+assert([result()[0] for _ in range(2)] == [2, 0])
+
+# Malformed requests are answered, not fatal
+judge.send(b"nonsense")
+assert(result()[0] == 1)
+send([record(["./hello"])])
+code, _, _, message = result()
+assert(code == 1 and b"Expected 11 arguments" in message)
+
+judge.close()
+assert(p.wait() == 0)
+os.rmdir(scratch)
@@ -7,6 +7,7 @@
  */
 
 #include <cassert>
+#include <cerrno>
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
@@ -15,6 +16,12 @@
 #include <string>
 #include <sys/fcntl.h>
 #include <sys/resource.h>
+#include <vector>
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#endif
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -40,6 +47,27 @@ enum : int {
 	RS_MLE = 4,
 };
 
+// One run of the program, as given on the command line
+struct Run {
+	std::string fileName;
+	std::string runArgs;
+	std::string stdinRedirect;
+	std::string stdoutRedirect;
+	std::string stderrRedirect;
+	long long timeLimitMs;
+	long long memoryLimitMib;
+	long long rawTimeLimitMs;
+	long long rawMemoryLimitMib;
+	std::string readableFile;
+	std::string writableFile;
+	bool shell = false;
+};
+
+struct Usage {
+	long long timeUsedMs = -1;
+	long long memoryUsed = -1;
+};
+
 /**
  * argv[1]: executable file path
  * argv[2]: 执行选手程序时，传递的命令行参数，但不包含 argv0
@@ -52,138 +80,501 @@ enum : int {
  * argv[9]: 原始（未经语言设置缩放的）空间限制（MiB）
  * argv[10]: 选手程序只读的文件
  * argv[11]: 选手程序只写的文件
+ * argv[12]: 可选，为 shell 时通过 bash -c 运行，参数中的变量、通配符等会被展开；
+ *           否则参数只按引号与反斜杠拆分，直接 exec 选手程序
  */
-auto main(int argc, char *argv[]) -> int {
-	if (argc != 12) {
+static auto parseRun(int argc, char *argv[]) -> Run {
+	Run run;
+	run.fileName = argv[1];
+	run.runArgs = argv[2];
+	run.stdinRedirect = argv[3];
+	run.stdoutRedirect = argv[4];
+	run.stderrRedirect = argv[5];
+	run.timeLimitMs = std::stoll(argv[6]);
+	run.memoryLimitMib = std::stoll(argv[7]);
+	run.rawTimeLimitMs = std::stoll(argv[8]);
+	run.rawMemoryLimitMib = std::stoll(argv[9]);
+	run.readableFile = argv[10];
+	run.writableFile = argv[11];
+	run.shell = argc == 13 && strcmp(argv[12], "shell") == 0;
+	return run;
+}
+
+// RS_MLE or RS_FAIL if the program cannot even be loaded, -1 otherwise
+static auto checkStaticMemory(const Run &run, Usage &usage, std::string &message) -> int {
+	if (run.memoryLimitMib <= 0) {
+		return -1;
+	}
+
+	ssize_t staticMemoryUsageByte = calculateStaticMemoryUsage(run.fileName);
+	if (staticMemoryUsageByte == -1) {
+		message += "Error in calculating static memory usage\n";
+		return RS_FAIL;
+	}
+	if (staticMemoryUsageByte > run.memoryLimitMib * 1024 * 1024) {
+		// If static memory usage exceeds the limit, it's an MLE.
+		usage.timeUsedMs = 0;
+		usage.memoryUsed = staticMemoryUsageByte;
+		message += "Static memory usage exceeds the limit\n";
+		return RS_MLE;
+	}
+	return -1;
+}
+
+// Split the arguments into words as a shell would, but without expanding
+// anything. False if a quote is not closed.
+static auto splitArguments(const std::string &line, std::vector<std::string> &words) -> bool {
+	std::string word;
+	bool inWord = false;
+	char quote = 0;
+
+	for (size_t i = 0; i < line.size(); i++) {
+		char c = line[i];
+		if (quote == '\'') {
+			if (c == '\'') {
+				quote = 0;
+			} else {
+				word += c;
+			}
+		} else if (quote == '"') {
+			if (c == '"') {
+				quote = 0;
+			} else if (c == '\\' && i + 1 < line.size() && strchr("$`\"\\\n", line[i + 1]) != NULL) {
+				if (line[++i] != '\n') {
+					word += line[i];
+				}
+			} else {
+				word += c;
+			}
+		} else if (c == '\'' || c == '"') {
+			quote = c;
+			inWord = true;
+		} else if (c == '\\') {
+			if (++i < line.size() && line[i] != '\n') {
+				word += line[i];
+				inWord = true;
+			}
+		} else if (c == ' ' || c == '\t' || c == '\n') {
+			if (inWord) {
+				words.push_back(word);
+				word.clear();
+				inWord = false;
+			}
+		} else {
+			word += c;
+			inWord = true;
+		}
+	}
+
+	if (inWord) {
+		words.push_back(word);
+	}
+	return quote == 0;
+}
+
+// In the forked child: redirect, apply the limits and exec the program
+[[noreturn]] static void execute(const Run &run, int cgroupProcsFd) {
+	std::string finalStdinRedirect = run.stdinRedirect.empty() ? "/dev/null" : run.stdinRedirect;
+	// Without waiting for a writer of a FIFO, such as a pipe from an
+	// interactor: once every writer is gone it reads as empty
+	int stdinFd = open(finalStdinRedirect.c_str(), O_RDONLY | O_NONBLOCK);
+	if (stdinFd == -1 || dup2(stdinFd, STDIN_FILENO) == -1) {
+		perror("open stdin");
+		exit(RS_FAIL);
+	}
+	if (stdinFd != STDIN_FILENO) {
+		close(stdinFd);
+	}
+	fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) & ~O_NONBLOCK);
+	std::string finalStdoutRedirect = run.stdoutRedirect.empty() ? "/dev/null" : run.stdoutRedirect;
+	if (freopen(finalStdoutRedirect.c_str(), "w", stdout) == NULL) {
+		perror("freopen stdout");
+		exit(RS_FAIL);
+	}
+	std::string finalStderrRedirect = run.stderrRedirect.empty() ? "/dev/null" : run.stderrRedirect;
+	if (freopen(finalStderrRedirect.c_str(), "w", stderr) == NULL) {
+		perror("freopen stderr");
+		exit(RS_FAIL);
+	}
+
+	bool inCgroup = false;
+	if (cgroupProcsFd != -1) {
+		// Move only the program, so that the watcher itself is not accounted
+		inCgroup = write(cgroupProcsFd, "0", 1) == 1;
+		if (! inCgroup) {
+			perror("cgroup");
+		}
+		close(cgroupProcsFd);
+	}
+
+	ssize_t actualMemoryRLimit = getMemoryRLimit(run.memoryLimitMib);
+	rlimit memlim{}, stalim{}, timlim{};
+
+	if (run.memoryLimitMib > 0 && inCgroup) {
+		// memory.max only counts what is actually used, reserving address
+		// space (as many runtimes do) is no longer an MLE
+		memlim = (rlimit){RLIM_INFINITY, RLIM_INFINITY};
+		stalim = (rlimit){(rlim_t)actualMemoryRLimit, (rlim_t)actualMemoryRLimit};
+	} else if (run.memoryLimitMib > 0) {
+		memlim = (rlimit){(rlim_t)actualMemoryRLimit, (rlim_t)actualMemoryRLimit};
+		stalim = (rlimit){(rlim_t)actualMemoryRLimit, (rlim_t)actualMemoryRLimit};
+	} else {
+		// No memory limit specified, set to infinity
+		memlim = (rlimit){RLIM_INFINITY, RLIM_INFINITY};
+		stalim = (rlimit){(rlim_t)2147483647LL, (rlim_t)2147483647LL};
+	}
+
+	// Calculate time limit in seconds, rounding up
+	rlim_t soft_time_limit_sec = (run.timeLimitMs + 999) / 1000;
+	timlim = (rlimit){soft_time_limit_sec, soft_time_limit_sec + 1}; // Soft limit + 1 for hard limit
+
+	setrlimit(RLIMIT_AS, &memlim);
+	setrlimit(RLIMIT_STACK, &stalim);
+	setrlimit(RLIMIT_CPU, &timlim);
+
+	if (run.shell) {
+		std::ostringstream ss;
+		ss << '"';
+		ss << run.fileName;
+		ss << "\" ";
+		ss << run.runArgs;
+		std::string runCmd = ss.str();
+
+		execlp("bash", "bash", "-c", runCmd.c_str(), NULL);
+		perror("execlp");
+		exit(RS_FAIL);
+	}
+
+	// No shell in between, which would cost a process start of its own and
+	// be accounted to the program
+	std::vector<std::string> words{run.fileName};
+	if (! splitArguments(run.runArgs, words)) {
+		fprintf(stderr, "Unterminated quote in the arguments\n");
+		exit(RS_FAIL);
+	}
+	std::vector<char *> args;
+	for (auto &word : words) {
+		args.push_back(word.data());
+	}
+	args.push_back(NULL);
+
+	execvp(run.fileName.c_str(), args.data());
+	perror("execvp");
+	exit(RS_FAIL);
+}
+
+// Wait for the program started by execute() and judge how it ended
+static auto await(int child, const Run &run, Usage &usage, std::string &message) -> int {
+	struct rusage resourceUsage{};
+	int status = 0;
+
+	if (wait4(child, &status, 0, &resourceUsage) == -1) {
+		message += std::string("wait4: ") + strerror(errno) + "\n";
+		return RS_FAIL;
+	}
+
+	long long timeUsedMs = static_cast<long long>(resourceUsage.ru_utime.tv_sec * 1000 +
+	                                              resourceUsage.ru_utime.tv_usec / 1000);
+
+	if (WIFEXITED(status)) {
+		size_t memoryUsed = getMaxRSSInByte(resourceUsage.ru_maxrss);
+		usage.timeUsedMs = timeUsedMs;
+		usage.memoryUsed = static_cast<long long>(memoryUsed);
+		if (WEXITSTATUS(status) != 0) {
+			// Any non-zero exit status indicates a runtime error.
+			return RS_RE;
+		}
+		if (timeUsedMs > run.timeLimitMs) {
+			return RS_TLE;
+		}
+		if (run.memoryLimitMib >= 0 && usage.memoryUsed > run.memoryLimitMib * 1024 * 1024) {
+			return RS_MLE;
+		}
+		return RS_AC;
+	}
+
+	usage.timeUsedMs = timeUsedMs;
+	if (WTERMSIG(status) == SIGXCPU) {
+		return RS_TLE;
+	}
+	if (WTERMSIG(status) == SIGKILL || WTERMSIG(status) == SIGABRT) {
+		return RS_MLE;
+	}
+	return RS_RE;
+}
+
+auto watch(int argc, char *argv[]) -> int {
+	if (argc != 12 && argc != 13) {
 		printf("-1\n-1\n");
 		fprintf(stderr, "Expected 11 arguments, found %d\n", argc);
 		return RS_FAIL;
 	}
-	std::string fileName = argv[1];
-	std::string runArgs = argv[2];
-	std::string stdinRedirect = argv[3];
-	std::string stdoutRedirect = argv[4];
-	std::string stderrRedirect = argv[5];
-	long long timeLimitMs = std::stoll(argv[6]);
-	long long memoryLimitMib = std::stoll(argv[7]);
-	[[maybe_unused]] long long rawTimeLimitMs = std::stoll(argv[8]);
-	[[maybe_unused]] long long rawMemoryLimitMib = std::stoll(argv[9]);
-	[[maybe_unused]] std::string readableFile = argv[10];
-	[[maybe_unused]] std::string writableFile = argv[11];
+	Run run = parseRun(argc, argv);
 
 	initWatcher();
 
-	std::ostringstream ss;
-	ss << '"';
-	ss << fileName;
-	ss << "\" ";
-	ss << runArgs;
-	std::string runCmd = ss.str();
-
-	if (memoryLimitMib > 0) {
-		ssize_t staticMemoryUsageByte = calculateStaticMemoryUsage(fileName);
-		if (staticMemoryUsageByte == -1) {
-			printf("-1\n-1\n");
-			fprintf(stderr, "Error in calculating static memory usage\n");
-			return RS_FAIL;
-		}
-		if (staticMemoryUsageByte > memoryLimitMib * 1024 * 1024) {
-			// If static memory usage exceeds the limit, it's an MLE.
-			printf("0\n%zd\n", staticMemoryUsageByte);
-			fprintf(stderr, "Static memory usage exceeds the limit\n");
-			return RS_MLE;
-		}
+	// Set by the judge when the program has to run in a cgroup: a descriptor
+	// of the cgroup's cgroup.procs, which then limits the memory instead of
+	// RLIMIT_AS. Not to be seen by the program.
+	int cgroupProcsFd = -1;
+	if (const char *fd = getenv("LEMON_CGROUP_FD")) {
+		cgroupProcsFd = atoi(fd);
+		unsetenv("LEMON_CGROUP_FD");
 	}
 
-	ssize_t actualMemoryRLimit = getMemoryRLimit(memoryLimitMib);
+	Usage usage;
+	std::string message;
+	int code = checkStaticMemory(run, usage, message);
 
-	pid = fork();
+	if (code == -1) {
+		pid = fork();
 
-	if (pid > 0) {
-		// Parent process
-		signal(SIGINT, cleanUp);
-		signal(SIGABRT, cleanUp);
-		signal(SIGTERM, cleanUp);
-		struct rusage usage{};
-		int status = 0;
+		if (pid == 0) {
+			execute(run, cgroupProcsFd);
+		}
 
-		if (wait4(pid, &status, 0, &usage) == -1) {
-			printf("-1\n-1\n");
-			perror("wait4");
-			return RS_FAIL;
+		if (cgroupProcsFd != -1) {
+			close(cgroupProcsFd);
 		}
 
-		if (WIFEXITED(status)) {
-			long long timeUsedMs =
-			    static_cast<long long>(usage.ru_utime.tv_sec * 1000 + usage.ru_utime.tv_usec / 1000);
-			size_t memoryUsed = getMaxRSSInByte(usage.ru_maxrss);
-			printf("%lld\n%zu\n", timeUsedMs, memoryUsed);
-			if (WEXITSTATUS(status) != 0) {
-				// Any non-zero exit status indicates a runtime error.
-				return RS_RE;
-			}
-			if (timeUsedMs > timeLimitMs) {
-				return RS_TLE;
-			}
-			if (memoryUsed > memoryLimitMib * 1024 * 1024) {
-				return RS_MLE;
-			}
-			return RS_AC;
+		if (pid < 0) {
+			message += std::string("fork: ") + strerror(errno) + "\n";
+			code = RS_FAIL;
+		} else {
+			signal(SIGINT, cleanUp);
+			signal(SIGABRT, cleanUp);
+			signal(SIGTERM, cleanUp);
+			code = await(pid, run, usage, message);
 		}
+	}
 
-		if (WIFSIGNALED(status)) {
-			long long timeUsedMs =
-			    static_cast<long long>(usage.ru_utime.tv_sec * 1000 + usage.ru_utime.tv_usec / 1000);
-			printf("%lld\n-1\n", timeUsedMs);
-			if (WTERMSIG(status) == SIGXCPU) {
-				return RS_TLE;
-			}
-			if (WTERMSIG(status) == SIGKILL || WTERMSIG(status) == SIGABRT) {
-				return RS_MLE;
+	printf("%lld\n%lld\n", usage.timeUsedMs, usage.memoryUsed);
+	fputs(message.c_str(), stderr);
+	return code;
+}
+
+#ifdef __linux__
+
+// Remove everything below `dirFd` on the same filesystem. Mount points, such
+// as the watcher itself, stay where they are.
+static void wipeDirectory(int dirFd, dev_t device) {
+	DIR *dir = fdopendir(dirFd);
+	if (dir == NULL) {
+		close(dirFd);
+		return;
+	}
+
+	while (dirent *entry = readdir(dir)) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+			continue;
+		}
+		struct stat info{};
+		if (fstatat(dirfd(dir), entry->d_name, &info, AT_SYMLINK_NOFOLLOW) != 0 || info.st_dev != device) {
+			continue;
+		}
+		if (S_ISDIR(info.st_mode)) {
+			int childFd = openat(dirfd(dir), entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+			if (childFd >= 0) {
+				wipeDirectory(childFd, device);
 			}
-			return RS_RE;
+			unlinkat(dirfd(dir), entry->d_name, AT_REMOVEDIR);
+		} else {
+			unlinkat(dirfd(dir), entry->d_name, 0);
+		}
+	}
+
+	closedir(dir);
+}
+
+// Read what is available from a non-blocking pipe
+static void drain(int fd, std::string &buffer) {
+	char chunk[4096];
+	ssize_t length = 0;
+	while ((length = read(fd, chunk, sizeof(chunk))) > 0) {
+		buffer.append(chunk, length);
+	}
+}
+
+// One record of a batch: run the program once, in place of a whole watcher
+static auto serveRecord(const std::string &directory, std::vector<std::string> &arguments,
+                        std::vector<std::string> &environment, int cgroupProcsFd, Usage &usage,
+                        std::string &message) -> int {
+	if (arguments.size() != 11 && arguments.size() != 12) {
+		message += "Expected 11 arguments, found " + std::to_string(arguments.size() + 1) + "\n";
+		return RS_FAIL;
+	}
+	if (chdir(directory.c_str()) != 0) {
+		message += std::string("chdir: ") + strerror(errno) + "\n";
+		return RS_FAIL;
+	}
+
+	std::vector<char *> argv{NULL};
+	for (auto &argument : arguments) {
+		argv.push_back(argument.data());
+	}
+	Run run = parseRun(static_cast<int>(argv.size()), argv.data());
+
+	int code = checkStaticMemory(run, usage, message);
+	if (code != -1) {
+		return code;
+	}
+
+	// Whatever goes wrong before the exec is reported through this pipe
+	int errPipe[2];
+	if (pipe2(errPipe, O_CLOEXEC) != 0) {
+		message += std::string("pipe: ") + strerror(errno) + "\n";
+		return RS_FAIL;
+	}
+	fcntl(errPipe[0], F_SETFL, O_NONBLOCK);
+
+	int child = fork();
+	if (child == 0) {
+		dup2(errPipe[1], STDERR_FILENO);
+		clearenv();
+		for (auto &variable : environment) {
+			putenv(variable.data());
 		}
+		execute(run, cgroupProcsFd);
+	}
+	close(errPipe[1]);
+
+	if (child < 0) {
+		message += std::string("fork: ") + strerror(errno) + "\n";
+		code = RS_FAIL;
 	} else {
-		std::string finalStdinRedirect = stdinRedirect.empty() ? "/dev/null" : stdinRedirect;
-		if (freopen(finalStdinRedirect.c_str(), "r", stdin) == NULL) {
-			perror("freopen stdin");
-			exit(RS_FAIL);
+		code = await(child, run, usage, message);
+	}
+
+	std::string childMessage;
+	drain(errPipe[0], childMessage);
+	close(errPipe[0]);
+	message.insert(0, childMessage);
+	return code;
+}
+
+/**
+ * 预热的沙箱：评测机在每个评测线程上只启动一次 bwrap，其中运行 `watcher --zygote`，
+ * 之后每个测试点只需要一次 fork 与 exec。
+ *
+ * 标准输入是一个 SOCK_SEQPACKET 套接字，每个数据包包含一条或多条记录，依次运行。
+ * 每条记录的各项均以 '\0' 结尾：
+ *   工作目录、参数个数、参数（同上，不含 argv0）、环境变量个数、环境变量、
+ *   cgroup.procs 在随数据包传来（SCM_RIGHTS）的文件描述符中的序号（没有则为 -1）。
+ * 每条记录运行结束后立即回复一个数据包："退出代码 时间 内存\n" 后接错误信息。
+ *
+ * argv[2...]: 每次运行结束后清空的目录（如沙箱内的 /tmp）
+ */
+static auto serve(int argc, char *argv[]) -> int {
+	const int sock = STDIN_FILENO;
+	const int maxDescriptors = 64;
+	std::vector<char> packet(1 << 20);
+
+	initWatcher();
+
+	while (true) {
+		char control[CMSG_SPACE(sizeof(int) * maxDescriptors)];
+		iovec iov{packet.data(), packet.size()};
+		msghdr header{};
+		header.msg_iov = &iov;
+		header.msg_iovlen = 1;
+		header.msg_control = control;
+		header.msg_controllen = sizeof(control);
+
+		ssize_t length = recvmsg(sock, &header, MSG_CMSG_CLOEXEC);
+		if (length <= 0) {
+			// The judge has gone away
+			return 0;
 		}
-		std::string finalStdoutRedirect = stdoutRedirect.empty() ? "/dev/null" : stdoutRedirect;
-		if (freopen(finalStdoutRedirect.c_str(), "w", stdout) == NULL) {
-			perror("freopen stdout");
-			exit(RS_FAIL);
+
+		std::vector<int> descriptors;
+		for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg != NULL; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+				size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+				descriptors.resize(descriptors.size() + count);
+				memcpy(descriptors.data() + descriptors.size() - count, CMSG_DATA(cmsg), count * sizeof(int));
+			}
 		}
-		std::string finalStderrRedirect = stderrRedirect.empty() ? "/dev/null" : stderrRedirect;
-		if (freopen(finalStderrRedirect.c_str(), "w", stderr) == NULL) {
-			perror("freopen stderr");
-			exit(RS_FAIL);
+
+		std::vector<std::string> fields;
+		for (ssize_t begin = 0, end = 0; end < length; end++) {
+			if (packet[end] == '\0') {
+				fields.emplace_back(packet.data() + begin, end - begin);
+				begin = end + 1;
+			}
 		}
 
-		rlimit memlim{}, stalim{}, timlim{};
+		// At least one reply, even to an empty packet
+		size_t at = 0;
+		do {
+			Usage usage;
+			std::string message;
+			int code = RS_FAIL;
 
-		if (memoryLimitMib > 0) {
-			memlim = (rlimit){(rlim_t)actualMemoryRLimit, (rlim_t)actualMemoryRLimit};
-			stalim = (rlimit){(rlim_t)actualMemoryRLimit, (rlim_t)actualMemoryRLimit};
-		} else {
-			// No memory limit specified, set to infinity
-			memlim = (rlimit){RLIM_INFINITY, RLIM_INFINITY};
-			stalim = (rlimit){(rlim_t)2147483647LL, (rlim_t)2147483647LL};
-		}
+			// Counts are checked against what is left, a malformed record ends the packet
+			size_t left = fields.size() - at;
+			size_t argumentCount = left >= 2 ? strtoul(fields[at + 1].c_str(), NULL, 10) : left;
+			size_t environmentCount = argumentCount + 3 <= left
+			                              ? strtoul(fields[at + 2 + argumentCount].c_str(), NULL, 10)
+			                              : left;
+			bool valid = argumentCount < left && environmentCount < left &&
+			             argumentCount + environmentCount + 4 <= left;
+
+			if (valid) {
+				std::vector<std::string> arguments(fields.begin() + at + 2,
+				                                   fields.begin() + at + 2 + argumentCount);
+				std::vector<std::string> environment(fields.begin() + at + 3 + argumentCount,
+				                                     fields.begin() + at + 3 + argumentCount + environmentCount);
+				long index = strtol(fields[at + 3 + argumentCount + environmentCount].c_str(), NULL, 10);
+				int cgroupProcsFd = index >= 0 && index < static_cast<long>(descriptors.size())
+				                        ? descriptors[index]
+				                        : -1;
+
+				code = serveRecord(fields[at], arguments, environment, cgroupProcsFd, usage, message);
+				at += argumentCount + environmentCount + 4;
+			} else {
+				message = "Malformed request\n";
+				at = fields.size();
+			}
 
-		// Calculate time limit in seconds, rounding up
-		rlim_t soft_time_limit_sec = (timeLimitMs + 999) / 1000;
-		timlim = (rlimit){soft_time_limit_sec, soft_time_limit_sec + 1}; // Soft limit + 1 for hard limit
+			// Nothing the program leaves behind may reach the next one. Only as
+			// the first process of a PID namespace (under bwrap, the second after
+			// its init), where this means the processes of the sandbox.
+			if (getpid() <= 2) {
+				kill(-1, SIGKILL);
+			}
+			if (chdir("/") != 0) {
+				perror("chdir");
+			}
+			for (int i = 2; i < argc; i++) {
+				int dirFd = open(argv[i], O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				struct stat info{};
+				if (dirFd >= 0 && fstat(dirFd, &info) == 0) {
+					wipeDirectory(dirFd, info.st_dev);
+				} else if (dirFd >= 0) {
+					close(dirFd);
+				}
+			}
 
-		setrlimit(RLIMIT_AS, &memlim);
-		setrlimit(RLIMIT_STACK, &stalim);
-		setrlimit(RLIMIT_CPU, &timlim);
+			std::string reply = std::to_string(code) + " " + std::to_string(usage.timeUsedMs) + " " +
+			                    std::to_string(usage.memoryUsed) + "\n" + message.substr(0, 65536);
+			if (send(sock, reply.data(), reply.size(), MSG_NOSIGNAL) < 0) {
+				return 0;
+			}
+		} while (at < fields.size());
 
-		if (execlp("bash", "bash", "-c", runCmd.c_str(), NULL) == -1) {
-			perror("execlp");
-			exit(RS_FAIL);
+		for (int fd : descriptors) {
+			close(fd);
 		}
 	}
+}
+
+#endif
 
-	return 0;
+auto main(int argc, char *argv[]) -> int {
+#ifdef __linux__
+	if (argc >= 2 && strcmp(argv[1], "--zygote") == 0) {
+		return serve(argc, argv);
+	}
+#endif
+	return watch(argc, argv);
 }